@@ -0,0 +1,85 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <sstream>
+#include <tally/tally.h>
+
+namespace {
+
+    // A registry of `n' counters, gauges and histograms, in thirds.
+    class Registry {
+    public:
+        explicit Registry(size_t n) {
+            _scope = tally::ScopeBuilder().prefix("bench").tags({{"service", "bench"}, {"zone", "z1"}}).build();
+            for (size_t i = 0; i < n / 3; ++i) {
+                auto c = std::make_unique<tally::Counter<int64_t>>("counter_" + std::to_string(i), "counter help",
+                                                                   _scope.get());
+                c->increment(static_cast<double>(i));
+                _counters.push_back(std::move(c));
+                _gauges.push_back(std::make_unique<tally::Gauge<double>>("gauge_" + std::to_string(i), "gauge help",
+                                                                         i * 0.5, _scope.get()));
+                auto h = std::make_unique<tally::Histogram>(tally::Buckets::exponential_values(1, 2, 16),
+                                                            "histogram_" + std::to_string(i), "histogram help",
+                                                            _scope.get());
+                h->record(static_cast<double>(i % 1000));
+                _histograms.push_back(std::move(h));
+            }
+        }
+
+    private:
+        std::shared_ptr<tally::Scope> _scope;
+        std::vector<std::unique_ptr<tally::Counter<int64_t>>> _counters;
+        std::vector<std::unique_ptr<tally::Gauge<double>>> _gauges;
+        std::vector<std::unique_ptr<tally::Histogram>> _histograms;
+    };
+
+    void BM_Exposition(benchmark::State &state, tally::ExpositionFormat format) {
+        Registry registry(static_cast<size_t>(state.range(0)));
+        size_t bytes = 0;
+        for (auto _: state) {
+            auto out = tally::Reporter::get_reporting(format);
+            bytes = out.size();
+            benchmark::DoNotOptimize(out);
+        }
+        state.counters["bytes"] = static_cast<double>(bytes);
+        state.SetBytesProcessed(static_cast<int64_t>(bytes) * state.iterations());
+    }
+
+    BENCHMARK_CAPTURE(BM_Exposition, text, tally::ExpositionFormat::kPrometheusText)
+            ->Arg(300)->Arg(3000)->Arg(30000)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_Exposition, openmetrics, tally::ExpositionFormat::kOpenMetricsText)
+            ->Arg(300)->Arg(3000)->Arg(30000)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_Exposition, protobuf, tally::ExpositionFormat::kProtobufDelimited)
+            ->Arg(300)->Arg(3000)->Arg(30000)->Unit(benchmark::kMillisecond);
+
+    // Rendering threads of a large registry, see ReportOptions::parallelism().
+    void BM_ParallelExposition(benchmark::State &state, tally::ExpositionFormat format) {
+        Registry registry(static_cast<size_t>(state.range(0)));
+        tally::ReportOptions options;
+        options.parallelism(static_cast<int32_t>(state.range(1)));
+        for (auto _: state) {
+            auto out = tally::Reporter::get_reporting(format, &options);
+            benchmark::DoNotOptimize(out);
+        }
+    }
+
+    BENCHMARK_CAPTURE(BM_ParallelExposition, text, tally::ExpositionFormat::kPrometheusText)
+            ->ArgsProduct({{300000}, {1, 2, 4, 8, 16}})->Unit(benchmark::kMillisecond)->UseRealTime();
+    BENCHMARK_CAPTURE(BM_ParallelExposition, protobuf, tally::ExpositionFormat::kProtobufDelimited)
+            ->ArgsProduct({{300000}, {1, 2, 4, 8, 16}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,39 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <benchmark/benchmark.h>
+#include <tally/tally.h>
+
+namespace {
+
+    // Recording from several threads into one recorder, while a reader
+    // takes values as the sampling thread would.
+    template<typename R>
+    void BM_Record(benchmark::State &state) {
+        static R recorder;
+        int64_t latency = 1;
+        int64_t n = 0;
+        for (auto _: state) {
+            recorder << latency;
+            latency = latency * 7 % 100003;
+            if (state.thread_index() == 0 && ++n % 100000 == 0) {
+                benchmark::DoNotOptimize(recorder.get_value());
+            }
+        }
+    }
+
+    BENCHMARK_TEMPLATE(BM_Record, tally::detail::Percentile)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,110 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tally/tally.h>
+
+namespace {
+
+    // Long-lived threads adding into one counter.
+    template<typename C>
+    void BM_Add(benchmark::State &state) {
+        static C counter;
+        for (auto _: state) {
+            counter << 1;
+        }
+    }
+
+    BENCHMARK_TEMPLATE(BM_Add, tally::Counter<int64_t>)->ThreadRange(1, 8)->UseRealTime();
+    BENCHMARK_TEMPLATE(BM_Add, tally::PerCpuCounter<int64_t>)->ThreadRange(1, 8)->UseRealTime();
+
+    // An in-flight gauge: every request increments on start and
+    // decrements on finish.
+    void BM_InflightAtomic(benchmark::State &state) {
+        static std::atomic<int64_t> inflight{0};
+        for (auto _: state) {
+            inflight.fetch_add(1, std::memory_order_relaxed);
+            inflight.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    BENCHMARK(BM_InflightAtomic)->ThreadRange(1, 8)->UseRealTime();
+
+    void BM_InflightUpDown(benchmark::State &state) {
+        static tally::UpDownGauge<int64_t> inflight;
+        for (auto _: state) {
+            inflight.increment();
+            inflight.decrement();
+        }
+    }
+
+    BENCHMARK(BM_InflightUpDown)->ThreadRange(1, 8)->UseRealTime();
+
+    // Keys of a skewed stream into a TopK, as on a request path.
+    void BM_TopKAdd(benchmark::State &state) {
+        static tally::TopK hot(20);
+        std::vector<std::string> keys;
+        for (int i = 0; i < 4096; ++i) {
+            keys.push_back("tenant_" + std::to_string(i % 7 == 0 ? i : i % 16));
+        }
+        size_t n = 0;
+        for (auto _: state) {
+            hot << keys[n++ % keys.size()];
+        }
+    }
+
+    BENCHMARK(BM_TopKAdd)->ThreadRange(1, 8)->UseRealTime();
+
+    // Adds staged in a LocalBatch flushed every 1000 adds.
+    void BM_AddBatched(benchmark::State &state) {
+        static tally::Counter<int64_t> counter;
+        tally::LocalBatch batch;
+        auto &slot = batch.get(&counter);
+        int64_t n = 0;
+        for (auto _: state) {
+            slot << 1;
+            if (++n % 1000 == 0) {
+                batch.flush();
+            }
+        }
+    }
+
+    BENCHMARK(BM_AddBatched)->ThreadRange(1, 8)->UseRealTime();
+
+    // Every iteration is a thread adding `range(0)' times and exiting, as
+    // in services spawning a thread per task.
+    template<typename C>
+    void BM_ThreadChurn(benchmark::State &state) {
+        C counter;
+        const int64_t adds = state.range(0);
+        for (auto _: state) {
+            std::thread t([&counter, adds] {
+                for (int64_t i = 0; i < adds; ++i) {
+                    counter << 1;
+                }
+            });
+            t.join();
+        }
+        benchmark::DoNotOptimize(counter.get_value());
+    }
+
+    BENCHMARK_TEMPLATE(BM_ThreadChurn, tally::Counter<int64_t>)->Arg(1)->Arg(100);
+    BENCHMARK_TEMPLATE(BM_ThreadChurn, tally::PerCpuCounter<int64_t>)->Arg(1)->Arg(100);
+
+}  // namespace
@@ -0,0 +1,59 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <tally/tally.h>
+
+namespace {
+
+    // One tick of the sampling thread over `n' windowed variables, samples
+    // are taken by hand so that no sampling thread is involved. The cost of
+    // sampling in a second is a tick times the ticks per second.
+    template<typename R>
+    void BM_SamplingTick(benchmark::State &state) {
+        const size_t n = static_cast<size_t>(state.range(0));
+        const int64_t period_ms = state.range(1);
+        const int64_t ticks_per_second = 1000 / period_ms;
+        std::vector<std::unique_ptr<R>> vars(n);
+        std::vector<std::unique_ptr<typename R::sampler_type>> samplers(n);
+        for (size_t i = 0; i < n; ++i) {
+            vars[i] = std::make_unique<R>();
+            samplers[i] = std::make_unique<typename R::sampler_type>(vars[i].get());
+            samplers[i]->set_sampling_period_us(period_ms * 1000);
+            // A 10 seconds window.
+            samplers[i]->set_window_size(10 * ticks_per_second);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        for (auto _: state) {
+            for (size_t i = 0; i < n; ++i) {
+                *vars[i] << static_cast<int64_t>(i);
+                samplers[i]->take_sample();
+            }
+        }
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // Share of a core spent on sampling.
+        state.counters["cpu_share"] = elapsed / static_cast<double>(state.iterations()) *
+                                      static_cast<double>(ticks_per_second);
+    }
+
+    BENCHMARK_TEMPLATE(BM_SamplingTick, tally::Counter<int64_t>)
+            ->ArgsProduct({{1000, 10000}, {1000, 100, 10}})->Unit(benchmark::kMicrosecond);
+    BENCHMARK_TEMPLATE(BM_SamplingTick, tally::MaxerGauge<int64_t>)
+            ->ArgsProduct({{1000, 10000}, {1000, 100, 10}})->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,67 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <tally/tally.h>
+
+namespace {
+
+    struct DummyMutex {
+        void lock() {}
+
+        void unlock() {}
+    };
+
+    // Per-measurement overhead of the clocks: a start and a stop.
+    void BM_TimeCost(benchmark::State &state) {
+        turbo::TimeCost timer;
+        int64_t total = 0;
+        for (auto _: state) {
+            timer.reset();
+            timer.stop();
+            total += timer.n_elapsed();
+        }
+        benchmark::DoNotOptimize(total);
+    }
+
+    BENCHMARK(BM_TimeCost);
+
+    void BM_CycleTimer(benchmark::State &state) {
+        tally::CycleTimer timer;
+        int64_t total = 0;
+        for (auto _: state) {
+            timer.start();
+            timer.stop();
+            total += timer.n_elapsed();
+        }
+        benchmark::DoNotOptimize(total);
+        state.counters["tsc"] = tally::CycleClock::tsc_enabled();
+    }
+
+    BENCHMARK(BM_CycleTimer);
+
+    // A timed lock acquisition which records into an AverageGauge.
+    void BM_MutexWithRecorder(benchmark::State &state) {
+        tally::AverageGauge recorder;
+        tally::MutexWithRecorder<DummyMutex> mutex(recorder);
+        for (auto _: state) {
+            std::lock_guard<tally::MutexWithRecorder<DummyMutex>> guard(mutex);
+        }
+    }
+
+    BENCHMARK(BM_MutexWithRecorder);
+
+}  // namespace
@@ -36,6 +36,12 @@ TURBO_FLAG(int32_t, tally_default_report_interval_ms,
 TURBO_FLAG(int32_t, tally_min_report_interval_ms,
            10, "milliseconds between report reporter");
 
+TURBO_FLAG(int32_t, tally_scrape_cache_max_age_ms,
+           1000, "scrapes within this milliseconds share the cached reporting");
+
+TURBO_FLAG(int32_t, tally_report_parallelism, 1,
+           "threads rendering prometheus/openmetrics/protobuf reporting, 0 for number of cpu cores");
+
 TURBO_FLAG(std::string, prometheus_scope_name, "kumo_prometheus", "kumo prometheus prefix");
 
 TURBO_FLAG(int32_t, prometheus_collect_interval_s, 5, "seconds between prometheus report reporter");
@@ -55,6 +61,9 @@ TURBO_FLAG(std::string, tally_root_scope_tags, "", "default flag scope tags eg.
 TURBO_FLAG(uint64_t, tally_latency_scale_factor, 1,
            "latency scale factor, used by method status, etc., latency_us = latency * latency_scale_factor");
 
+TURBO_FLAG(bool, tally_use_tsc, true,
+           "Time TimeRecorder and lock timers with the TSC if it's invariant, read when the TSC is calibrated shortly after start");
+
 
 TURBO_FLAG(int32_t, tally_latency_p2, 90, "Second latency percentile").on_validate(
     [](std::string_view value, std::string *err) noexcept -> bool {
@@ -151,6 +160,10 @@ namespace tally {
 
         tally_group->enable_flags_option(FLAGS_tally_min_report_interval_ms);
 
+        tally_group->enable_flags_option(FLAGS_tally_scrape_cache_max_age_ms);
+
+        tally_group->enable_flags_option(FLAGS_tally_report_parallelism);
+
         tally_group->enable_flags_option(FLAGS_prometheus_scope_name);
         tally_group->enable_flags_option(FLAGS_prometheus_collect_interval_s);
 
@@ -167,6 +180,8 @@ namespace tally {
 
         tally_group->enable_flags_option(FLAGS_tally_latency_scale_factor);
 
+        tally_group->enable_flags_option(FLAGS_tally_use_tsc);
+
         tally_group->enable_flags_option(FLAGS_tally_latency_p1);
         tally_group->enable_flags_option(FLAGS_tally_latency_p2);
         tally_group->enable_flags_option(FLAGS_tally_latency_p3);
@@ -36,6 +36,10 @@ TURBO_DECLARE_FLAG(int32_t, tally_default_report_interval_ms);
 
 TURBO_DECLARE_FLAG(int32_t, tally_min_report_interval_ms);
 
+TURBO_DECLARE_FLAG(int32_t, tally_scrape_cache_max_age_ms);
+
+TURBO_DECLARE_FLAG(int32_t, tally_report_parallelism);
+
 TURBO_DECLARE_FLAG(std::string, prometheus_scope_name);
 TURBO_DECLARE_FLAG(int32_t, prometheus_collect_interval_s);
 
@@ -52,6 +56,8 @@ TURBO_DECLARE_FLAG(std::string, tally_scope_separator);
 
 TURBO_DECLARE_FLAG(uint64_t, tally_latency_scale_factor);
 
+TURBO_DECLARE_FLAG(bool, tally_use_tsc);
+
 TURBO_DECLARE_FLAG(int32_t, tally_latency_p1);
 TURBO_DECLARE_FLAG(int32_t, tally_latency_p2);
 TURBO_DECLARE_FLAG(int32_t, tally_latency_p3);
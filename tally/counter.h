@@ -21,12 +21,13 @@
 
 namespace tally {
 
-    template<typename T, typename Enable = void>
+    // `Agents' is where values are kept before combining, see PerCpuAgents.
+    template<typename T, typename Enable = void, typename Agents = PerThreadAgents>
     class Counter;
-    template<typename T>
-    class Counter<T, typename std::enable_if<std::is_integral_v<T> || std::is_floating_point_v<T>>::type> :  public Reducer<T, detail::AddTo<T>, detail::MinusFrom<T> > {
+    template<typename T, typename Agents>
+    class Counter<T, typename std::enable_if<std::is_integral_v<T> || std::is_floating_point_v<T>>::type, Agents> :  public Reducer<T, detail::AddTo<T>, detail::MinusFrom<T>, Agents> {
     public:
-        typedef Reducer<T, detail::AddTo<T>, detail::MinusFrom<T> > Base;
+        typedef Reducer<T, detail::AddTo<T>, detail::MinusFrom<T>, Agents> Base;
         typedef T value_type;
         typedef typename Base::sampler_type sampler_type;
     public:
@@ -58,6 +59,10 @@ namespace tally {
         ~Counter() { Variable::hide(); }
     };
 
+    // A Counter sharded by cpu, for threads which come and go frequently.
+    template<typename T>
+    using PerCpuCounter = Counter<T, void, PerCpuAgents>;
+
     //using Counter = CounterBase<double>;
     //using IntCount = CounterBase<int64_t>;
 
@@ -0,0 +1,55 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/distinct_counter.h>
+
+namespace tally::detail {
+
+    double hll_estimate(const uint8_t *registers, size_t precision) {
+        const size_t m = size_t(1) << precision;
+        double alpha;
+        switch (m) {
+            case 16:
+                alpha = 0.673;
+                break;
+            case 32:
+                alpha = 0.697;
+                break;
+            case 64:
+                alpha = 0.709;
+                break;
+            default:
+                alpha = 0.7213 / (1.0 + 1.079 / static_cast<double>(m));
+                break;
+        }
+        double sum = 0;
+        size_t zeros = 0;
+        for (size_t i = 0; i < m; ++i) {
+            sum += std::ldexp(1.0, -static_cast<int>(registers[i]));
+            if (registers[i] == 0) {
+                ++zeros;
+            }
+        }
+        const double dm = static_cast<double>(m);
+        const double estimate = alpha * dm * dm / sum;
+        // Empty registers count small cardinalities more precisely. No
+        // correction is needed for large ones with 64-bit hashes.
+        if (estimate <= 2.5 * dm && zeros != 0) {
+            return dm * std::log(dm / static_cast<double>(zeros));
+        }
+        return estimate;
+    }
+
+}  // namespace tally::detail
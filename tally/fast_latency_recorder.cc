@@ -0,0 +1,496 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/fast_latency_recorder.h>
+#include <turbo/log/logging.h>
+
+namespace tally {
+
+    namespace detail {
+
+        class AddLatencyStats {
+        public:
+            AddLatencyStats(int64_t latency, IntervalQueue *pending) : _latency(latency), _pending(pending) {}
+
+            void operator()(GlobalValue<FusedLatency::combiner_type> &global_value,
+                            LocalLatencyStats &local_value) const {
+                const size_t index = get_interval_index(_latency);
+                ThreadLocalPercentileSamples &samples = local_value.samples;
+                PercentileInterval<ThreadLocalPercentileSamples::SAMPLE_SIZE> &
+                        interval = samples.get_interval_at(index);
+                if (interval.full()) {
+                    if (!_pending->push(index, interval)) {
+                        LatencyStats *g = global_value.lock();
+                        _pending->merge_into(&g->samples);
+                        g->samples.get_interval_at(index).merge(interval);
+                        g->samples._num_added += interval.added_count();
+                        global_value.unlock();
+                    }
+                    samples._num_added -= interval.added_count();
+                    interval.clear();
+                }
+                interval.add32(encode_sample(_latency, index));
+                ++samples._num_added;
+                ++local_value.count;
+                local_value.sum += _latency;
+                if (_latency > local_value.max) {
+                    local_value.max = _latency;
+                }
+            }
+
+        private:
+            int64_t _latency;
+            IntervalQueue *_pending;
+        };
+
+        struct MergePendingStats {
+            void operator()(LatencyStats &g, IntervalQueue *pending) const {
+                pending->merge_into(&g.samples);
+            }
+        };
+
+        FusedLatency::FusedLatency() : _combiner(nullptr), _sampler(nullptr) {
+            _combiner = new combiner_type;
+        }
+
+        FusedLatency::~FusedLatency() {
+            // Have to destroy sampler first to avoid the race between destruction and
+            // sampler
+            if (_sampler != nullptr) {
+                _sampler->destroy();
+                _sampler = nullptr;
+            }
+            delete _combiner;
+        }
+
+        void FusedLatency::merge_pending() const {
+            if (!_pending.empty()) {
+                _combiner->modify_global(MergePendingStats(), &_pending);
+            }
+        }
+
+        FusedLatency::value_type FusedLatency::reset() {
+            merge_pending();
+            std::unique_lock lk(_total_mutex);
+            value_type v = _combiner->reset_all_agents();
+            _reset_total.sum += v.sum;
+            _reset_total.num += v.count;
+            return v;
+        }
+
+        FusedLatency::value_type FusedLatency::get_value() const {
+            merge_pending();
+            return _combiner->combine_agents();
+        }
+
+        Stat FusedLatency::total() const {
+            std::unique_lock lk(_total_mutex);
+            return _reset_total;
+        }
+
+        FusedLatency &FusedLatency::operator<<(int64_t latency) {
+            agent_type *agent = _combiner->get_or_create_tls_agent();
+            if (TURBO_UNLIKELY(!agent)) {
+                KLOG(FATAL) << "Fail to create agent";
+                return *this;
+            }
+            if (latency < 0) {
+                if (!_debug_name.empty()) {
+                    KLOG(WARNING) << "Input=" << latency << " to `" << _debug_name
+                                  << "' is negative, drop";
+                } else {
+                    KLOG(WARNING) << "Input=" << latency << " to FusedLatency("
+                                  << (void *) this << ") is negative, drop";
+                }
+                return *this;
+            }
+            agent->merge_global(AddLatencyStats(latency, &_pending));
+            return *this;
+        }
+
+        namespace {
+            // Iterates percentile samples of LatencyStats for combine_of().
+            class StatsSamplesIterator {
+            public:
+                explicit StatsSamplesIterator(std::vector<LatencyStats>::const_iterator it) : _it(it) {}
+
+                const GlobalPercentileSamples *operator->() const { return &_it->samples; }
+
+                StatsSamplesIterator &operator++() {
+                    ++_it;
+                    return *this;
+                }
+
+                bool operator!=(const StatsSamplesIterator &rhs) const { return _it != rhs._it; }
+
+            private:
+                std::vector<LatencyStats>::const_iterator _it;
+            };
+        }  // namespace
+
+    }  // namespace detail
+
+    VariableAttr FastLatencyRecorder::View::attr_of(Kind kind) {
+        switch (kind) {
+            case LATENCY:
+            case MAX_LATENCY:
+                return VariableAttr::window_attr();
+            case LATENCY_PERCENTILES:
+                return VariableAttr::status_attr();
+            case LATENCY_CDF:
+                return VariableAttr::cdf_attr();
+            case LATENCY_SUMMARY:
+                return VariableAttr::summary_attr();
+            default:
+                return VariableAttr::gauge_attr();
+        }
+    }
+
+    FastLatencyRecorder::View::View(FastLatencyRecorder *owner, Kind kind)
+            : Variable(attr_of(kind)), _owner(owner), _kind(kind) {}
+
+    void FastLatencyRecorder::View::describe(std::ostream &os, bool) const {
+        switch (_kind) {
+            case LATENCY:
+                os << _owner->snapshot()->latency;
+                break;
+            case LATENCY_PERCENTILES:
+                os << _owner->latency_percentiles();
+                break;
+            case LATENCY_CDF:
+                detail::describe_cdf(os, *_owner->combined_samples());
+                break;
+            case LATENCY_SUMMARY:
+                detail::describe_summary(os, _owner->summary());
+                break;
+            default: {
+                std::any value;
+                get_value(&value);
+                os << std::any_cast<int64_t>(value);
+                break;
+            }
+        }
+    }
+
+    void FastLatencyRecorder::View::get_value(std::any *value) const {
+        switch (_kind) {
+            case LATENCY:
+                *value = _owner->snapshot()->latency;
+                break;
+            case MAX_LATENCY:
+                *value = _owner->max_latency();
+                break;
+            case COUNT:
+                *value = _owner->count();
+                break;
+            case QPS:
+                *value = _owner->qps();
+                break;
+            case LATENCY_PERCENTILES:
+                *value = _owner->latency_percentiles();
+                break;
+            case LATENCY_CDF:
+                value->reset();
+                break;
+            case LATENCY_SUMMARY:
+                *value = _owner->summary();
+                break;
+            default:
+                *value = _owner->percentile_at(_kind);
+                break;
+        }
+    }
+
+    MetricSample FastLatencyRecorder::View::get_metric(const turbo::Time &stamp) const {
+        if (_kind == LATENCY_SUMMARY) {
+            return MetricSample{VariableType::summary_type(), _owner->summary(), stamp};
+        }
+        if (!type().is_gauge()) {
+            return Variable::get_metric(stamp);
+        }
+        std::any value;
+        get_value(&value);
+        return MetricSample{VariableType::gauge_type(),
+                            static_cast<double>(std::any_cast<int64_t>(value)), stamp};
+    }
+
+    turbo::Status FastLatencyRecorder::View::describe_series(
+            std::ostream &os, const SeriesOptions &options) const {
+        // Like CDF of LatencyRecorder, the only one plotted.
+        if (_kind != LATENCY_CDF) {
+            return turbo::unavailable_error("");
+        }
+        if (!options.test_only) {
+            describe(os, false);
+        }
+        return turbo::OkStatus();
+    }
+
+    FastLatencyRecorder::FastLatencyRecorder(time_t window_size)
+            : _sampler(_stats.get_sampler()),
+              _window_size(window_size > 0 ? window_size : turbo::get_flag(FLAGS_tally_dump_interval)),
+              _latency(this, LATENCY),
+              _max_latency(this, MAX_LATENCY),
+              _count(this, COUNT),
+              _qps(this, QPS),
+              _latency_p1(this, LATENCY_P1),
+              _latency_p2(this, LATENCY_P2),
+              _latency_p3(this, LATENCY_P3),
+              _latency_999(this, LATENCY_999),
+              _latency_9999(this, LATENCY_9999),
+              _latency_percentiles(this, LATENCY_PERCENTILES),
+              _latency_cdf(this, LATENCY_CDF),
+              _latency_summary(this, LATENCY_SUMMARY) {
+        KCHECK_EQ(0, _sampler->set_window_size(_window_size));
+    }
+
+    FastLatencyRecorder::FastLatencyRecorder(const std::string_view &prefix, std::string_view help,
+                                             Scope *scope, time_t window_size)
+            : FastLatencyRecorder(window_size) {
+        auto rs = expose(prefix, help, scope);
+        if (!rs.ok()) {
+            KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                            << "expose FastLatencyRecorder failed: " << prefix << "to scope" << scope->id();
+            KLOG(WARNING) << "expose FastLatencyRecorder failed: " << prefix << "to scope" << scope->id();
+        }
+    }
+
+    FastLatencyRecorder::FastLatencyRecorder(const std::string_view &prefix, std::string_view help,
+                                             Scope *scope, time_t window_size,
+                                             std::vector<double> quantiles)
+            : FastLatencyRecorder(window_size) {
+        auto rs = set_quantiles(std::move(quantiles));
+        if (rs.ok()) {
+            rs = expose(prefix, help, scope);
+        }
+        if (!rs.ok()) {
+            KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                            << "expose FastLatencyRecorder failed: " << prefix << "to scope" << scope->id();
+            KLOG(WARNING) << "expose FastLatencyRecorder failed: " << prefix << "to scope" << scope->id();
+        }
+    }
+
+    std::shared_ptr<const FastLatencyRecorder::Snapshot> FastLatencyRecorder::snapshot() const {
+        const int64_t time_us = _sampler->latest_time_us();
+        // Readers of the same tick wait for the one deriving.
+        std::unique_lock lk(_snapshot_mutex);
+        if (_snapshot && time_us == _snapshot->time_us) {
+            return _snapshot;
+        }
+        auto s = std::make_shared<Snapshot>();
+        s->time_us = time_us;
+        s->total = _stats.total();
+        std::vector<detail::LatencyStats> stats;
+        int64_t span_us = 0;
+        if (_sampler->get_span_samples(_window_size, &stats, &span_us)) {
+            for (auto &st: stats) {
+                s->latency.sum += st.sum;
+                s->latency.num += st.count;
+                s->max_latency = std::max(s->max_latency, st.max);
+            }
+            // Use floating point to avoid overflow.
+            if (span_us > 0) {
+                s->qps = detail::double_to_random_int(s->latency.num * 1000000.0 / span_us);
+            }
+        }
+        auto cb = combine_samples(time_us, stats);
+        for (auto r: {turbo::get_flag(FLAGS_tally_latency_p1) / 100.0,
+                      turbo::get_flag(FLAGS_tally_latency_p2) / 100.0,
+                      turbo::get_flag(FLAGS_tally_latency_p3) / 100.0, 0.999, 0.9999}) {
+            s->percentiles.emplace_back(r, cb->get_number(r));
+        }
+        for (auto q: _quantiles) {
+            s->percentiles.emplace_back(q, cb->get_number(q));
+        }
+        _snapshot = s;
+        return s;
+    }
+
+    std::shared_ptr<detail::CombinedPercentileSamples> FastLatencyRecorder::combined_samples() const {
+        const int64_t time_us = _sampler->latest_time_us();
+        std::unique_lock lk(_snapshot_mutex);
+        auto cb = _combined.lock();
+        if (cb && time_us == _combined_time_us) {
+            return cb;
+        }
+        std::vector<detail::LatencyStats> stats;
+        int64_t span_us = 0;
+        _sampler->get_span_samples(_window_size, &stats, &span_us);
+        return combine_samples(time_us, stats);
+    }
+
+    std::shared_ptr<detail::CombinedPercentileSamples> FastLatencyRecorder::combine_samples(
+            int64_t time_us, const std::vector<detail::LatencyStats> &stats) const {
+        auto cb = std::make_shared<detail::CombinedPercentileSamples>();
+        cb->combine_of(detail::StatsSamplesIterator(stats.begin()),
+                       detail::StatsSamplesIterator(stats.end()));
+        cb->sort();
+        _combined = cb;
+        _combined_time_us = time_us;
+        return cb;
+    }
+
+    int64_t FastLatencyRecorder::percentile_at(Kind kind) const {
+        switch (kind) {
+            case LATENCY_P1:
+                return latency_percentile(turbo::get_flag(FLAGS_tally_latency_p1) / 100.0);
+            case LATENCY_P2:
+                return latency_percentile(turbo::get_flag(FLAGS_tally_latency_p2) / 100.0);
+            case LATENCY_P3:
+                return latency_percentile(turbo::get_flag(FLAGS_tally_latency_p3) / 100.0);
+            case LATENCY_999:
+                return latency_percentile(0.999);
+            case LATENCY_9999:
+                return latency_percentile(0.9999);
+            default:
+                return 0;
+        }
+    }
+
+    int64_t FastLatencyRecorder::latency() const {
+        return snapshot()->latency.get_average_int();
+    }
+
+    int64_t FastLatencyRecorder::latency_percentile(double ratio) const {
+        return percentile_of(*snapshot(), ratio);
+    }
+
+    int64_t FastLatencyRecorder::percentile_of(const Snapshot &s, double ratio) const {
+        for (auto &p: s.percentiles) {
+            if (p.first == ratio) {
+                return p.second;
+            }
+        }
+        return combined_samples()->get_number(ratio);
+    }
+
+    Vector<int64_t, 4> FastLatencyRecorder::latency_percentiles() const {
+        // NOTE: We don't show 99.99% since it's often significantly larger than
+        // other values and make other curves on the plotted graph small and
+        // hard to read.
+        Vector<int64_t, 4> result;
+        result[0] = latency_percentile(turbo::get_flag(FLAGS_tally_latency_p1) / 100.0);
+        result[1] = latency_percentile(turbo::get_flag(FLAGS_tally_latency_p2) / 100.0);
+        result[2] = latency_percentile(turbo::get_flag(FLAGS_tally_latency_p3) / 100.0);
+        result[3] = latency_percentile(0.999);
+        return result;
+    }
+
+    int64_t FastLatencyRecorder::max_latency() const {
+        return snapshot()->max_latency;
+    }
+
+    int64_t FastLatencyRecorder::qps() const {
+        return snapshot()->qps;
+    }
+
+    SummarySample FastLatencyRecorder::summary() const {
+        SummarySample s;
+        auto snap = snapshot();
+        s.quantiles.reserve(_quantiles.size());
+        for (auto q: _quantiles) {
+            s.quantiles.emplace_back(q, percentile_of(*snap, q));
+        }
+        s.sample_sum = static_cast<double>(snap->total.sum);
+        s.sample_count = snap->total.num;
+        return s;
+    }
+
+    turbo::Status FastLatencyRecorder::set_quantiles(std::vector<double> quantiles) {
+        if (!_latency.name().empty()) {
+            return turbo::failed_precondition_error("set quantiles of exposed FastLatencyRecorder %s",
+                                                    _latency.name());
+        }
+        auto rs = detail::normalize_quantiles(&quantiles);
+        if (!rs.ok()) {
+            return rs;
+        }
+        _quantiles = std::move(quantiles);
+        return turbo::OkStatus();
+    }
+
+    turbo::Status FastLatencyRecorder::expose(std::string_view prefix_src, std::string_view help, Scope *scope) {
+        // User may add "_latency" as the suffix, remove it.
+        std::string_view prefix_v = prefix_src;
+        if (turbo::ends_with_ignore_case(prefix_v, "latency")) {
+            prefix_v.remove_suffix(7);
+            if (prefix_v.empty()) {
+                KLOG(ERROR) << "Invalid prefix=" << prefix_src;
+                return turbo::invalid_argument_error("Invalid prefix=%s", prefix_src);
+            }
+        }
+        _stats.set_debug_name(prefix_v);
+
+        const std::string prefix(prefix_v);
+        const std::pair<View *, std::string> views[] = {
+                {&_latency,             prefix + "_latency"},
+                {&_max_latency,         prefix + "_max_latency"},
+                {&_count,               prefix + "_count"},
+                {&_qps,                 prefix + "_qps"},
+                {&_latency_p1,          turbo::str_format("%s_latency_%d", prefix.c_str(),
+                                                          (int) turbo::get_flag(FLAGS_tally_latency_p1))},
+                {&_latency_p2,          turbo::str_format("%s_latency_%d", prefix.c_str(),
+                                                          (int) turbo::get_flag(FLAGS_tally_latency_p2))},
+                {&_latency_p3,          turbo::str_format("%s_latency_%d", prefix.c_str(),
+                                                          (int) turbo::get_flag(FLAGS_tally_latency_p3))},
+                {&_latency_999,         prefix + "_latency_999"},
+                {&_latency_9999,        prefix + "_latency_9999"},
+                {&_latency_percentiles, prefix + "_latency_percentiles"},
+                {&_latency_cdf,         prefix + "_latency_cdf"},
+        };
+        for (auto &v: views) {
+            // One summary in place of the percentile gauges.
+            if (!_quantiles.empty() && v.first->is_percentile_gauge()) {
+                continue;
+            }
+            auto rs = v.first->expose(v.second, help, scope);
+            if (!rs.ok()) {
+                return rs;
+            }
+        }
+        if (!_quantiles.empty()) {
+            return _latency_summary.expose(prefix + "_latency_summary", help, scope);
+        }
+        return turbo::OkStatus();
+    }
+
+    void FastLatencyRecorder::hide() {
+        _latency.hide();
+        _max_latency.hide();
+        _count.hide();
+        _qps.hide();
+        _latency_p1.hide();
+        _latency_p2.hide();
+        _latency_p3.hide();
+        _latency_999.hide();
+        _latency_9999.hide();
+        _latency_percentiles.hide();
+        _latency_cdf.hide();
+        _latency_summary.hide();
+    }
+
+    FastLatencyRecorder &FastLatencyRecorder::operator<<(int64_t latency) {
+        _stats << latency / turbo::get_flag(FLAGS_tally_latency_scale_factor);
+        return *this;
+    }
+
+    std::ostream &operator<<(std::ostream &os, const FastLatencyRecorder &rec) {
+        return os << "{latency=" << rec.latency()
+                  << " max" << rec.window_size() << '=' << rec.max_latency()
+                  << " qps=" << rec.qps()
+                  << " count=" << rec.count() << '}';
+    }
+
+}  // namespace tally
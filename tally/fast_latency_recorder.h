@@ -0,0 +1,293 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#pragma once
+
+#include <tally/latency_recorder.h>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace tally {
+    namespace detail {
+
+        // Latencies recorded by a thread since the last sampling. count, sum,
+        // max and percentile samples are fused so that recording locks a
+        // single tls element.
+        struct LocalLatencyStats {
+            int64_t count{0};
+            int64_t sum{0};
+            int64_t max{0};
+            ThreadLocalPercentileSamples samples;
+        };
+
+        struct LatencyStats {
+            int64_t count{0};
+            int64_t sum{0};
+            int64_t max{0};
+            GlobalPercentileSamples samples;
+        };
+
+        // A reducer of latencies whose value is reset at each sampling, like
+        // Percentile. NOTE: DON'T use it directly, use FastLatencyRecorder.
+        class FusedLatency {
+        public:
+            FusedLatency(const FusedLatency &) = delete;
+            FusedLatency &operator=(const FusedLatency &) = delete;
+
+            struct MergeLatencyStats {
+                template<typename Stats>
+                void operator()(LatencyStats &s1, const Stats &s2) const {
+                    s1.count += s2.count;
+                    s1.sum += s2.sum;
+                    s1.max = std::max(s1.max, s2.max);
+                    s1.samples.merge(s2.samples);
+                }
+            };
+
+            typedef LatencyStats value_type;
+            typedef ReducerSampler<FusedLatency, LatencyStats,
+                    MergeLatencyStats, VoidOp> sampler_type;
+            typedef AgentCombiner<LatencyStats, LocalLatencyStats,
+                    MergeLatencyStats> combiner_type;
+            typedef combiner_type::Agent agent_type;
+
+            FusedLatency();
+
+            ~FusedLatency();
+
+            MergeLatencyStats op() const { return MergeLatencyStats(); }
+
+            VoidOp inv_op() const { return VoidOp(); }
+
+            sampler_type *get_sampler() {
+                if (nullptr == _sampler) {
+                    _sampler = new sampler_type(this);
+                    _sampler->schedule();
+                }
+                return _sampler;
+            }
+
+            value_type reset();
+
+            value_type get_value() const;
+
+            // Sum and number of latencies taken by reset() so far, which
+            // doesn't combine agents.
+            Stat total() const;
+
+            FusedLatency &operator<<(int64_t latency);
+
+            void set_debug_name(std::string_view name) {
+                _debug_name.assign(name.data(), name.size());
+            }
+
+        private:
+            // Merge intervals published by writers into the global stats.
+            void merge_pending() const;
+
+            combiner_type *_combiner;
+            sampler_type *_sampler;
+            mutable IntervalQueue _pending;
+            // Latencies taken away by reset().
+            mutable std::mutex _total_mutex;
+            Stat _reset_total;
+            std::string _debug_name;
+        };
+
+    }  // namespace detail
+
+    // A LatencyRecorder for processes having lots of recorders. Recording
+    // touches one tls element instead of three and a single sampler derives
+    // everything at most once per second, which makes it cheaper to write
+    // and much smaller. Exposes the same variables as LatencyRecorder, but
+    // they don't save series.
+    class FastLatencyRecorder {
+    public:
+        FastLatencyRecorder() : FastLatencyRecorder(-1) {}
+
+        explicit FastLatencyRecorder(time_t window_size);
+
+        FastLatencyRecorder(const std::string_view &prefix, std::string_view help,
+                            Scope *scope = ScopeInstance::instance()->get_default().get(),
+                            time_t window_size = -1);
+
+        // Export `quantiles' as a summary, see LatencyRecorder::set_quantiles().
+        FastLatencyRecorder(const std::string_view &prefix, std::string_view help,
+                            Scope *scope, time_t window_size, std::vector<double> quantiles);
+
+        ~FastLatencyRecorder() { hide(); }
+
+        FastLatencyRecorder(const FastLatencyRecorder &) = delete;
+        FastLatencyRecorder &operator=(const FastLatencyRecorder &) = delete;
+
+        // Record the latency.
+        FastLatencyRecorder &operator<<(int64_t latency);
+
+        // Record `d' in time_unit().
+        FastLatencyRecorder &record(turbo::Duration d) { return *this << to_time_unit(d, _time_unit); }
+
+        // Expose the same variables as LatencyRecorder::expose.
+        turbo::Status expose(std::string_view prefix, std::string_view help, Scope *scope);
+
+        // Hide all exposed variables, called in dtor as well.
+        void hide();
+
+        // Same as LatencyRecorder::set_quantiles().
+        turbo::Status set_quantiles(std::vector<double> quantiles);
+
+        time_t window_size() const { return _window_size; }
+
+        // Unit of durations passed to record(), microseconds by default.
+        TimeUnit time_unit() const { return _time_unit; }
+
+        void set_time_unit(TimeUnit unit) { _time_unit = unit; }
+
+        // Get the average latency in recent window_size-to-ctor seconds.
+        int64_t latency() const;
+
+        // Get |ratio|-ile latency in recent window_size-to-ctor seconds.
+        int64_t latency_percentile(double ratio) const;
+
+        // Get p1/p2/p3/99.9-ile latencies in recent window_size-to-ctor seconds.
+        Vector<int64_t, 4> latency_percentiles() const;
+
+        // Get the max latency in recent window_size-to-ctor seconds.
+        int64_t max_latency() const;
+
+        // Get the total number of latencies recorded until the latest
+        // sampling tick.
+        int64_t count() const { return snapshot()->total.num; }
+
+        // Get qps in recent window_size-to-ctor seconds.
+        int64_t qps() const;
+
+        // Quantiles of the window, with sum and count of all latencies.
+        SummarySample summary() const;
+
+        const std::string &latency_name() const { return _latency.name(); }
+
+        const std::string &latency_percentiles_name() const { return _latency_percentiles.name(); }
+
+        const std::string &latency_cdf_name() const { return _latency_cdf.name(); }
+
+        const std::string &max_latency_name() const { return _max_latency.name(); }
+
+        const std::string &count_name() const { return _count.name(); }
+
+        const std::string &qps_name() const { return _qps.name(); }
+
+        const std::string &latency_summary_name() const { return _latency_summary.name(); }
+
+    private:
+        // What's derived from the window, once per sampling tick.
+        struct Snapshot {
+            int64_t time_us{0};
+            Stat latency;
+            int64_t max_latency{0};
+            int64_t qps{0};
+            // All latencies ever sampled.
+            Stat total;
+            // (ratio, latency) of the exported percentiles and quantiles.
+            // The combined samples are not kept, they are kilobytes.
+            std::vector<std::pair<double, int64_t>> percentiles;
+        };
+
+        enum Kind {
+            LATENCY,
+            MAX_LATENCY,
+            COUNT,
+            QPS,
+            LATENCY_P1,
+            LATENCY_P2,
+            LATENCY_P3,
+            LATENCY_999,
+            LATENCY_9999,
+            LATENCY_PERCENTILES,
+            LATENCY_CDF,
+            LATENCY_SUMMARY,
+        };
+
+        // An exposed variable, which reads from the snapshot.
+        class View : public Variable {
+        public:
+            View(FastLatencyRecorder *owner, Kind kind);
+
+            ~View() { hide(); }
+
+            void describe(std::ostream &os, bool quote_string) const override;
+
+            void get_value(std::any *value) const override;
+
+            MetricSample get_metric(const turbo::Time &stamp) const override;
+
+            turbo::Status describe_series(std::ostream &os, const SeriesOptions &options) const override;
+
+            // One of the gauges of p1/p2/p3/99.9/99.99-ile latencies.
+            bool is_percentile_gauge() const { return _kind >= LATENCY_P1 && _kind <= LATENCY_9999; }
+
+        private:
+            // Same as what LatencyRecorder exposes.
+            static VariableAttr attr_of(Kind kind);
+
+            FastLatencyRecorder *_owner;
+            Kind _kind;
+        };
+
+        std::shared_ptr<const Snapshot> snapshot() const;
+
+        // `ratio'-ile latency of `s', from the combined samples if it's not
+        // one of the percentiles kept.
+        int64_t percentile_of(const Snapshot &s, double ratio) const;
+
+        // Samples of the window, combined again if no reader holds the
+        // ones of the latest tick.
+        std::shared_ptr<detail::CombinedPercentileSamples> combined_samples() const;
+
+        // Called with _snapshot_mutex held.
+        std::shared_ptr<detail::CombinedPercentileSamples> combine_samples(
+                int64_t time_us, const std::vector<detail::LatencyStats> &stats) const;
+
+        int64_t percentile_at(Kind kind) const;
+
+    private:
+        detail::FusedLatency _stats;
+        detail::FusedLatency::sampler_type *_sampler;
+        time_t _window_size;
+        TimeUnit _time_unit{TimeUnit::kMicroseconds};
+
+        View _latency;
+        View _max_latency;
+        View _count;
+        View _qps;
+        View _latency_p1;
+        View _latency_p2;
+        View _latency_p3;
+        View _latency_999;
+        View _latency_9999;
+        View _latency_percentiles;
+        View _latency_cdf;
+        std::vector<double> _quantiles;
+        View _latency_summary;
+
+        mutable std::mutex _snapshot_mutex;
+        mutable std::shared_ptr<const Snapshot> _snapshot;
+        mutable std::weak_ptr<detail::CombinedPercentileSamples> _combined;
+        mutable int64_t _combined_time_us{0};
+    };
+
+    std::ostream &operator<<(std::ostream &os, const FastLatencyRecorder &);
+
+}  // namespace tally
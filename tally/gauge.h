@@ -118,12 +118,12 @@ namespace tally {
 
     using SimpleGauge = Gauge<double>;
 
-    template <typename T, typename Enabler = void>
+    template <typename T, typename Enabler = void, typename Agents = PerThreadAgents>
     class MaxerGauge;
-    template<typename T>
-    class MaxerGauge<T, typename std::enable_if<detail::is_atomical<T>::value>::type> : public Reducer<T, detail::MaxTo<T> > {
+    template<typename T, typename Agents>
+    class MaxerGauge<T, typename std::enable_if<detail::is_atomical<T>::value>::type, Agents> : public Reducer<T, detail::MaxTo<T>, detail::VoidOp, Agents> {
     public:
-        typedef Reducer<T, detail::MaxTo<T> > Base;
+        typedef Reducer<T, detail::MaxTo<T>, detail::VoidOp, Agents> Base;
         typedef T value_type;
         typedef typename Base::sampler_type sampler_type;
     public:
@@ -151,12 +151,12 @@ namespace tally {
     };
 
 
-    template <typename T, typename Enabler = void>
+    template <typename T, typename Enabler = void, typename Agents = PerThreadAgents>
     class MinerGauge;
-    template<typename T>
-    class MinerGauge<T, typename std::enable_if<detail::is_atomical<T>::value>::type> : public Reducer<T, detail::MinTo<T> > {
+    template<typename T, typename Agents>
+    class MinerGauge<T, typename std::enable_if<detail::is_atomical<T>::value>::type, Agents> : public Reducer<T, detail::MinTo<T>, detail::VoidOp, Agents> {
     public:
-        typedef Reducer<T, detail::MinTo<T> > Base;
+        typedef Reducer<T, detail::MinTo<T>, detail::VoidOp, Agents> Base;
         typedef T value_type;
         typedef typename Base::sampler_type sampler_type;
     public:
@@ -184,6 +184,63 @@ namespace tally {
         ~MinerGauge() { Variable::hide(); }
     };
 
+    // A gauge which goes up and down by deltas, e.g. in-flight requests or
+    // queue depth. Deltas are summed in agents of threads like Counter, so
+    // increments and decrements from many threads do not contend on one
+    // cacheline, and deltas of exited threads stay in the sum. Exported
+    // as a gauge.
+    // Example:
+    //   tally::UpDownGauge<int64_t> g_inflight("rpc_inflight", "in-flight rpcs");
+    //   g_inflight.increment();
+    //   ...
+    //   g_inflight.decrement();
+    template <typename T, typename Enabler = void, typename Agents = PerThreadAgents>
+    class UpDownGauge;
+    template<typename T, typename Agents>
+    class UpDownGauge<T, typename std::enable_if<std::is_integral_v<T> || std::is_floating_point_v<T>>::type, Agents> : public Reducer<T, detail::AddTo<T>, detail::MinusFrom<T>, Agents> {
+    public:
+        typedef Reducer<T, detail::AddTo<T>, detail::MinusFrom<T>, Agents> Base;
+        typedef T value_type;
+        typedef typename Base::sampler_type sampler_type;
+    public:
+        UpDownGauge() : Base(VariableAttr::gauge_attr()) {}
+
+        explicit UpDownGauge(std::string_view name, std::string_view help, turbo::Nonnull<Scope *> scope = ScopeInstance::instance()->get_default().get())
+                : Base(VariableAttr::gauge_attr()) {
+            auto rs = this->expose(name, help, scope);
+            if(!rs.ok()) {
+                KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))<<"expose UpDownGauge failed: "<<name<<"to scope"<<scope->id();
+                KLOG(WARNING)<<"expose UpDownGauge failed: "<<name<<"to scope"<<scope->id();
+            }
+        }
+
+        UpDownGauge &increment(T v = 1) {
+            *this<<v;
+            return *this;
+        }
+
+        UpDownGauge &decrement(T v = 1) {
+            *this<<(-v);
+            return *this;
+        }
+
+        MetricSample get_metric(const turbo::Time &stamp) const override {
+            return MetricSample{VariableType::gauge_type(), static_cast<double>(this->get_value()), stamp};
+        }
+
+        ~UpDownGauge() { Variable::hide(); }
+    };
+
+
+    // Sharded by cpu, for threads which come and go frequently.
+    template<typename T>
+    using PerCpuMaxerGauge = MaxerGauge<T, void, PerCpuAgents>;
+
+    template<typename T>
+    using PerCpuMinerGauge = MinerGauge<T, void, PerCpuAgents>;
+
+    template<typename T>
+    using PerCpuUpDownGauge = UpDownGauge<T, void, PerCpuAgents>;
 
     // Display a updated-by-need value. This is done by passing in an user callback
     // which is called to produce the value.
@@ -442,6 +499,17 @@ namespace tally {
             }
         };
 
+        // Saturates instead of overflowing the sum.
+        struct AddToStat64 {
+            void operator()(Stat &lhs, int64_t rhs) const {
+                if (__builtin_add_overflow(lhs.sum, rhs, &lhs.sum)) {
+                    lhs.sum = rhs > 0 ? std::numeric_limits<int64_t>::max()
+                                      : std::numeric_limits<int64_t>::min();
+                }
+                lhs.num += 1;
+            }
+        };
+
         typedef detail::AgentCombiner<Stat, uint64_t, AddToStat> combiner_type;
         typedef combiner_type::Agent agent_type;
 
@@ -464,8 +532,9 @@ namespace tally {
             }
         }
 
-        // Note: The input type is acutally int. Use int64_t to check overflow.
-        AverageGauge &operator<<(int64_t/*note*/ sample);
+        // Samples fitting in int are accumulated in the tls element lock-free,
+        // larger ones take a locked slow path.
+        AverageGauge &operator<<(int64_t sample);
 
         int64_t average() const {
             return _combiner.combine_agents().get_average_int();
@@ -505,8 +574,8 @@ namespace tally {
             return _sampler;
         }
 
-        // This name is useful for printing overflow log in operator<< since
-        // IntRecorder is often used as the source of data and not exposed.
+        // Name of the recorder in logs, useful since IntRecorder is often
+        // used as the source of data and not exposed.
         void set_debug_name(const std::string_view &name) {
             _debug_name.assign(name.data(), name.size());
         }
@@ -575,26 +644,10 @@ namespace tally {
 
     inline AverageGauge &AverageGauge::operator<<(int64_t sample) {
         if (TURBO_UNLIKELY((int64_t) (int) sample != sample)) {
-            const char *reason = nullptr;
-            if (sample > std::numeric_limits<int>::max()) {
-                reason = "overflows";
-                sample = std::numeric_limits<int>::max();
-            } else {
-                reason = "underflows";
-                sample = std::numeric_limits<int>::min();
-            }
-            // Truncate to be max or min of int. We're using 44 bits to store the
-            // sum thus following aggregations are not likely to be over/underflow.
-            if (!name().empty()) {
-                KLOG(WARNING) << "Input=" << sample << " to `" << name()
-                             << "\' " << reason;
-            } else if (!_debug_name.empty()) {
-                KLOG(WARNING) << "Input=" << sample << " to `" << _debug_name
-                             << "\' " << reason;
-            } else {
-                KLOG(WARNING) << "Input=" << sample << " to IntRecorder("
-                             << (void *) this << ") " << reason;
-            }
+            // Too large for the compressed tls element, add to the global
+            // Stat which is 64-bit.
+            _combiner.modify_global(AddToStat64(), sample);
+            return *this;
         }
         agent_type *agent = _combiner.get_or_create_tls_agent();
         if (TURBO_UNLIKELY(!agent)) {
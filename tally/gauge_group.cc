@@ -0,0 +1,84 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/gauge_group.h>
+#include <tally/config.h>
+
+namespace tally {
+
+    GaugeGroup::GaugeGroup(size_t size, fill_type fill)
+            : _fill(std::move(fill)), _values(size, 0), _filled(false), _filled_us(0) {}
+
+    void GaugeGroup::refresh(const turbo::Time *stamp) {
+        const int64_t now_us = turbo::Time::current_microseconds();
+        if (_filled) {
+            if (stamp != nullptr ? *stamp == _stamp : now_us - _filled_us < 1000000) {
+                return;
+            }
+        }
+        if (stamp != nullptr) {
+            _stamp = *stamp;
+        }
+        _fill(_values.data());
+        _filled = true;
+        _filled_us = now_us;
+    }
+
+    double GaugeGroup::get_value(size_t index, const turbo::Time *stamp) {
+        std::unique_lock lk(_mutex);
+        refresh(stamp);
+        return index < _values.size() ? _values[index] : 0;
+    }
+
+    std::vector<double> GaugeGroup::get_values(const turbo::Time *stamp) {
+        std::unique_lock lk(_mutex);
+        refresh(stamp);
+        return _values;
+    }
+
+    MultiFuncGauge::MultiFuncGauge(std::string_view label_name, std::vector<std::string> label_values,
+                                   GaugeGroup::fill_type fill)
+            : Variable(VariableAttr::gauge_attr()), _label_name(label_name),
+              _label_values(std::move(label_values)), _group(_label_values.size(), std::move(fill)) {}
+
+    MultiFuncGauge::MultiFuncGauge(std::string_view name, std::string_view help, std::string_view label_name,
+                                   std::vector<std::string> label_values, GaugeGroup::fill_type fill,
+                                   turbo::Nonnull<Scope *> scope)
+            : MultiFuncGauge(label_name, std::move(label_values), std::move(fill)) {
+        auto rs = expose(name, help, scope);
+        if (!rs.ok()) {
+            KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                            << "expose MultiFuncGauge failed: " << name << "to scope" << scope->id();
+            KLOG(WARNING) << "expose MultiFuncGauge failed: " << name << "to scope" << scope->id();
+        }
+    }
+
+    void MultiFuncGauge::describe(std::ostream &os, bool) const {
+        auto values = get_value();
+        os << '{';
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i) {
+                os << ' ';
+            }
+            os << _label_values[i] << '=' << values[i];
+        }
+        os << '}';
+    }
+
+    MetricSample MultiFuncGauge::get_metric(const turbo::Time &stamp) const {
+        return {VariableType::gauge_type(), _label_values.empty() ? 0.0 : _group.get_value(0, &stamp), stamp};
+    }
+
+}  // namespace tally
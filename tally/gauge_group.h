@@ -0,0 +1,163 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include <tally/config.h>
+#include <tally/variable.h>
+#include <tally/scope.h>
+
+namespace tally {
+
+    // N values produced by one callback, for sources which are expensive to
+    // read but yield many values at once, e.g. allocator, connection pool
+    // or system memory stats. The callback fills the values into an array
+    // of N doubles. Values read with the stamp of a scrape share one call,
+    // and values read without a stamp, e.g. by describe(), reuse a call in
+    // the last second.
+    // Values are exposed by GroupGauge one by one or by MultiFuncGauge as a
+    // labelled family.
+    class GaugeGroup {
+    public:
+        typedef std::function<void(double *values)> fill_type;
+
+        GaugeGroup(size_t size, fill_type fill);
+
+        GaugeGroup(const GaugeGroup &) = delete;
+        GaugeGroup &operator=(const GaugeGroup &) = delete;
+
+        size_t size() const { return _values.size(); }
+
+        // The `index'-th value, the callback is called if `stamp' is a new
+        // one or null and the values are older than one second.
+        double get_value(size_t index, const turbo::Time *stamp = nullptr);
+
+        std::vector<double> get_values(const turbo::Time *stamp = nullptr);
+
+    private:
+        // Called with _mutex held.
+        void refresh(const turbo::Time *stamp);
+
+        const fill_type _fill;
+        std::mutex _mutex;
+        std::vector<double> _values;
+        bool _filled;
+        turbo::Time _stamp;
+        int64_t _filled_us;
+    };
+
+    // The `index'-th value of a GaugeGroup as a gauge of type T. Integral
+    // gauges are truncated from the group's doubles, which hold integers
+    // below 2^53 exactly. The group must outlive the gauge.
+    // Example:
+    //   tally::GaugeGroup g_pool_stats(3, [](double *values) {
+    //       auto stats = pool.stats();
+    //       values[0] = stats.active;
+    //       values[1] = stats.idle;
+    //       values[2] = stats.waiting;
+    //   });
+    //   tally::GroupGauge<int64_t> g_pool_active(&g_pool_stats, 0, "pool_active", "active connections");
+    //   tally::GroupGauge<int64_t> g_pool_idle(&g_pool_stats, 1, "pool_idle", "idle connections");
+    template<typename T = double>
+    class GroupGauge : public Variable {
+        static_assert(std::is_integral_v<T> || std::is_floating_point_v<T>, "GroupGauge needs an arithmetic type");
+    public:
+        typedef T value_type;
+
+        GroupGauge(GaugeGroup *group, size_t index)
+                : Variable(VariableAttr::gauge_attr()), _group(group), _index(index) {}
+
+        GroupGauge(GaugeGroup *group, size_t index, std::string_view name, std::string_view help,
+                   turbo::Nonnull<Scope *> scope = ScopeInstance::instance()->get_default().get())
+                : GroupGauge(group, index) {
+            auto rs = expose(name, help, scope);
+            if (!rs.ok()) {
+                KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                                << "expose GroupGauge failed: " << name << "to scope" << scope->id();
+                KLOG(WARNING) << "expose GroupGauge failed: " << name << "to scope" << scope->id();
+            }
+        }
+
+        ~GroupGauge() override { hide(); }
+
+        T get_value() const { return static_cast<T>(_group->get_value(_index)); }
+
+        void get_value(std::any *value) const override { *value = get_value(); }
+
+        void describe(std::ostream &os, bool) const override { os << get_value(); }
+
+        MetricSample get_metric(const turbo::Time &stamp) const override {
+            return {VariableType::gauge_type(), _group->get_value(_index, &stamp), stamp};
+        }
+
+    private:
+        GaugeGroup *_group;
+        const size_t _index;
+    };
+
+    // Values of one callback exported as one gauge family labelled by
+    // `label_name', see GaugeGroup.
+    // Example:
+    //   tally::MultiFuncGauge g_cache("cache_bytes", "cache memory", "state", {"used", "free"},
+    //           [](double *values) {
+    //               auto stats = cache.stats();
+    //               values[0] = stats.used;
+    //               values[1] = stats.free;
+    //           });
+    //   # cache_bytes{state="used"} 1024
+    //   # cache_bytes{state="free"} 3072
+    class MultiFuncGauge : public Variable {
+    public:
+        MultiFuncGauge(std::string_view label_name, std::vector<std::string> label_values,
+                       GaugeGroup::fill_type fill);
+
+        MultiFuncGauge(std::string_view name, std::string_view help, std::string_view label_name,
+                       std::vector<std::string> label_values, GaugeGroup::fill_type fill,
+                       turbo::Nonnull<Scope *> scope = ScopeInstance::instance()->get_default().get());
+
+        ~MultiFuncGauge() override { hide(); }
+
+        std::vector<double> get_value() const { return _group.get_values(); }
+
+        void get_value(std::any *value) const override { *value = get_value(); }
+
+        void describe(std::ostream &os, bool quote_string) const override;
+
+        // The first value.
+        MetricSample get_metric(const turbo::Time &stamp) const override;
+
+        bool has_children() const override { return true; }
+
+        size_t num_children() const override { return _label_values.size(); }
+
+        MetricSample get_child_metric(size_t index, const turbo::Time &stamp) const override {
+            return {VariableType::gauge_type(), _group.get_value(index, &stamp), stamp};
+        }
+
+        void child_labels(size_t index, turbo::flat_hash_map<std::string, std::string> *labels) const override {
+            (*labels)[_label_name] = _label_values[index];
+        }
+
+    private:
+        const std::string _label_name;
+        const std::vector<std::string> _label_values;
+        mutable GaugeGroup _group;
+    };
+
+}  // namespace tally
@@ -26,7 +26,7 @@ namespace tally {
     }
 
     Histogram::Histogram(const Buckets &buckets, std::string_view name, std::string_view help, turbo::Nonnull<Scope *> scope) noexcept
-    : Variable(VariableAttr::histogram_attr()), buckets_(create_buckets(buckets)){
+    : Variable(VariableAttr::histogram_attr()), buckets_(create_buckets(buckets)) {
         std::vector<Counter<int64_t>> buckets_tmp(buckets_.size());
         buckets_value_.swap(buckets_tmp);
         auto rs = expose(name,help,scope);
@@ -79,20 +79,51 @@ namespace tally {
         return histogram_buckets;
     }
 
-    void Histogram::record(double val) noexcept {
-        if(buckets_.empty()) {
-            return;
-        }
+    size_t Histogram::bucket_index(double val) const {
         // Find the first bucket who's upper bound is greater than val.
         auto it = std::upper_bound(buckets_.begin(), buckets_.end(), val,
                                    [](double lhs, const HistogramBucket &rhs) {
                                        return lhs < rhs.upper_bound;
                                    });
-       buckets_value_[it->bucket_id].increment(1);
+        return it->bucket_id;
+    }
+
+    void Histogram::record(double val) noexcept {
+        if(buckets_.empty()) {
+            return;
+        }
+       buckets_value_[bucket_index(val)].increment(1);
        sample_count_.increment(1);
        sample_sum_.increment(val);
     }
 
+    void Histogram::record(double val, const turbo::flat_hash_map<std::string, std::string> &exemplar_labels) noexcept {
+        if(buckets_.empty()) {
+            return;
+        }
+        auto index = bucket_index(val);
+        buckets_value_[index].increment(1);
+        sample_count_.increment(1);
+        sample_sum_.increment(val);
+        get_or_create_exemplars()->update(index, val, exemplar_labels);
+    }
+
+    detail::ExemplarStore *Histogram::get_or_create_exemplars() noexcept {
+        auto *store = exemplars_.load(std::memory_order_acquire);
+        if (store) {
+            return store;
+        }
+        // Most histograms never see an exemplar, so the store is created by
+        // the first one. The loser of a racing creation drops its copy.
+        auto created = std::make_unique<detail::ExemplarStore>(buckets_.size());
+        if (!exemplars_.compare_exchange_strong(store, created.get(), std::memory_order_acq_rel)) {
+            return store;
+        }
+        // Only the winner gets here, once.
+        exemplars_owner_ = std::move(created);
+        return exemplars_owner_.get();
+    }
+
     std::vector<HistogramBucket> Histogram::get_value() const {
         std::vector<HistogramBucket> result = buckets_;
         for(size_t i = 0; i < result.size(); i++) {
@@ -16,6 +16,8 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <turbo/container/flat_hash_map.h>
 #include <vector>
@@ -23,20 +25,25 @@
 #include <tally/buckets.h>
 #include <tally/histogram.h>
 #include <tally/impl/histogram_bucket.h>
+#include <tally/impl/exemplar.h>
 #include <tally/stats_reporter.h>
 #include <tally/stopwatch.h>
 #include <tally/variable.h>
 #include <tally/counter.h>
 #include <tally/scope.h>
+#include <tally/time_unit.h>
+#include <tally/utility/cycle_timer.h>
 #include <turbo/times/time.h>
 
 namespace tally {
 
     class Histogram;
+    class LocalBatch;
 
     class TimeRecorder {
     public:
-        TimeRecorder(turbo::Nonnull<Histogram *> h) : _hist(h), _timer() {}
+        TimeRecorder(turbo::Nonnull<Histogram *> h, TimeUnit unit = TimeUnit::kMicroseconds)
+                : _hist(h), _unit(unit), _timer() {}
 
         ~TimeRecorder();
 
@@ -46,7 +53,8 @@ namespace tally {
 
     private:
         Histogram *_hist{nullptr};
-        turbo::TimeCost _timer;
+        TimeUnit _unit;
+        CycleTimer _timer;
     };
 
     class Histogram : public Variable {
@@ -63,24 +71,48 @@ namespace tally {
         // Record the given value.
         void record(double) noexcept;
 
-        TimeRecorder record_timer() noexcept {
-            return  TimeRecorder(this);
+        // Record the given value and keep `exemplar_labels' as the latest
+        // exemplar of the bucket it falls in, e.g. {{"trace_id", "..."}}.
+        // Label sets longer than 128 characters are not kept as exemplar.
+        void record(double, const turbo::flat_hash_map<std::string, std::string> &exemplar_labels) noexcept;
+
+        // Record the lifetime of the returned timer in `unit'.
+        TimeRecorder record_timer(TimeUnit unit = TimeUnit::kMicroseconds) noexcept {
+            return  TimeRecorder(this, unit);
         }
 
         virtual MetricSample get_metric(const turbo::Time &stamp) const {
-            return {type(), HistogramSample{get_value(), sample_sum_.get_value(),
-                                            sample_count_.get_value()},
-                    stamp};
+            HistogramSample hs{get_value(), sample_sum_.get_value(), sample_count_.get_value(), {}};
+            if (auto *store = exemplars_.load(std::memory_order_acquire)) {
+                store->collect(&hs.exemplars);
+            }
+            return {type(), std::move(hs), stamp};
         }
 
         void set_buckets(const Buckets &buckets) noexcept;
 
         std::vector<HistogramBucket> get_value() const;
 
+        // Sum and number of all recorded values.
+        double sample_sum() const { return sample_sum_.get_value(); }
+
+        int64_t sample_count() const { return sample_count_.get_value(); }
+
         static std::vector<HistogramBucket> create_buckets(const Buckets &buckets);
 
+    private:
+        friend class LocalBatch;
+
+        size_t bucket_index(double val) const;
+
+        detail::ExemplarStore *get_or_create_exemplars() noexcept;
+
     private:
         std::vector<HistogramBucket> buckets_;
+        // Created on the first record() with exemplar labels, owned by
+        // `exemplars_owner_' and published to readers by `exemplars_'.
+        std::unique_ptr<detail::ExemplarStore> exemplars_owner_;
+        std::atomic<detail::ExemplarStore *> exemplars_{nullptr};
         std::vector<Counter<int64_t>> buckets_value_;
         Counter<double> sample_sum_;
         Counter<int64_t> sample_count_;
@@ -88,7 +120,8 @@ namespace tally {
 
     inline TimeRecorder::~TimeRecorder() {
         if (_hist) {
-            _hist->record(turbo::Duration::to_double_microseconds(_timer.stop()));
+            _timer.stop();
+            _hist->record(to_double_time_unit(_timer.elapsed(), _unit));
         }
     }
 }  // namespace tally
@@ -18,12 +18,14 @@
 #include <string>                       // std::string
 #include <vector>                       // std::vector
 #include <atomic>
+#include <cstring>
 #include <mutex>
+#include <thread>
 #include <tally/utility/type_traits.h>           // add_cr_non_integral
-#include <turbo/container/linked_list.h>
 #include <tally/impl/agent_group.h>    // detail::AgentGroup
 #include <tally/impl/is_atomical.h>
 #include <tally/impl/call_op_returning_void.h>
+#include <tally/utility/asymmetric_fence.h>
 
 namespace tally::detail {
 
@@ -62,13 +64,18 @@ namespace tally::detail {
         Combiner *_c;
     };
 
-// Abstraction of tls element whose operations are all atomic.
+    // Elements guarded by a mutex, see the specializations below.
     template<typename T, typename Enabler = void>
     class ElementContainer {
         template<typename> friend
         class GlobalValue;
 
     public:
+        // Set the value of an element not yet visible to other threads.
+        void init(const T &value) {
+            _value = value;
+        }
+
         void load(T *out) {
             std::unique_lock guard(_lock);
             *out = _value;
@@ -104,6 +111,112 @@ namespace tally::detail {
         std::mutex _lock;
     };
 
+    // Elements which are copied bytewise, such as Stat and Vector<T, N>, are
+    // written by the owning thread without any atomic RMW: modify() bumps a
+    // sequence counter around plain stores and load() retries until it
+    // copies the element between two equal and even counters.
+    // Other threads may only write the element in exchange() and store(),
+    // which must be serialized by the caller (the combiner's lock). Such a
+    // writer raises `_exclusive' and waits for the owner to leave modify(),
+    // while modify() checks `_exclusive' after raising `_writing'. The
+    // store-load ordering of the two sides is by AsymmetricFence, so that
+    // the owner only pays a compiler barrier.
+    // merge_global() is not available, elements needing it are not copied
+    // bytewise anyway.
+    template<typename T>
+    class ElementContainer<
+            T, typename std::enable_if<!is_atomical<T>::value &&
+                                       std::is_trivially_copyable<T>::value>::type> {
+    public:
+        // [Threadsafe]
+        void load(T *out) const {
+            for (;;) {
+                const uint32_t seq = _seq.load(std::memory_order_acquire);
+                if (!(seq & 1)) {
+                    std::memcpy(static_cast<void *>(out), &_value, sizeof(T));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (_seq.load(std::memory_order_relaxed) == seq) {
+                        return;
+                    }
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        // Set the value of an element not yet visible to other threads,
+        // without the handshake of store().
+        void init(const T &value) {
+            _value = value;
+        }
+
+        void store(const T &new_value) {
+            begin_exclusive();
+            AsymmetricFence::heavy();
+            exchange_exclusive(nullptr, new_value);
+        }
+
+        void exchange(T *prev, const T &new_value) {
+            begin_exclusive();
+            AsymmetricFence::heavy();
+            exchange_exclusive(prev, new_value);
+        }
+
+        // exchange() in two steps, so that the combiner resetting all agents
+        // pays one AsymmetricFence::heavy() in between rather than one per
+        // agent.
+        void begin_exclusive() {
+            _exclusive.store(true, std::memory_order_relaxed);
+        }
+
+        void exchange_exclusive(T *prev, const T &new_value) {
+            while (_writing.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            write([&] {
+                if (prev) {
+                    *prev = _value;
+                }
+                _value = new_value;
+            });
+            _exclusive.store(false, std::memory_order_release);
+        }
+
+        // Only called from the thread owning the element.
+        template<typename Op, typename T1>
+        void modify(const Op &op, const T1 &value2) {
+            for (;;) {
+                _writing.store(true, std::memory_order_relaxed);
+                AsymmetricFence::light();
+                if (TURBO_LIKELY(!_exclusive.load(std::memory_order_acquire))) {
+                    break;
+                }
+                // Let the other writer go first.
+                _writing.store(false, std::memory_order_release);
+                while (_exclusive.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+            }
+            write([&] { call_op_returning_void(op, _value, value2); });
+            _writing.store(false, std::memory_order_release);
+        }
+
+    private:
+        template<typename F>
+        void write(const F &f) {
+            const uint32_t seq = _seq.load(std::memory_order_relaxed);
+            _seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            f();
+            _seq.store(seq + 2, std::memory_order_release);
+        }
+
+        T _value;
+        std::atomic<uint32_t> _seq{0};
+        std::atomic<bool> _writing{false};
+        std::atomic<bool> _exclusive{false};
+    };
+
+    // Abstraction of tls element whose operations are all atomic.
     template<typename T>
     class ElementContainer<
             T, typename std::enable_if<is_atomical<T>::value>::type> {
@@ -114,6 +227,10 @@ namespace tally::detail {
             *out = _value.load(std::memory_order_relaxed);
         }
 
+        inline void init(T value) {
+            _value.store(value, std::memory_order_relaxed);
+        }
+
         inline void store(T new_value) {
             _value.store(new_value, std::memory_order_relaxed);
         }
@@ -148,6 +265,23 @@ namespace tally::detail {
         std::atomic<T> _value;
     };
 
+    // True if the container resets in begin_exclusive()/exchange_exclusive().
+    template<typename Container, typename = void>
+    struct has_exclusive_exchange : std::false_type {
+    };
+
+    template<typename Container>
+    struct has_exclusive_exchange<
+            Container, std::void_t<decltype(&Container::begin_exclusive)> > : std::true_type {
+    };
+
+    // Agents are linked in a lock-free list which readers walk under `_lock'
+    // while threads append new agents by CAS and retire theirs at exit
+    // without taking `_lock'. A retired agent stays in the list with its
+    // value until the next walk, by a reader or by a registering thread which
+    // finds `_lock' free, folds the value into `_global_result' and frees the
+    // agent; walks are serialized by `_lock', and appending only touches the
+    // head, so nobody else can be reaching the unlinked agent.
     template<typename ResultTp, typename ElementTp, typename BinaryOp>
     class AgentCombiner {
     public:
@@ -157,20 +291,11 @@ namespace tally::detail {
 
         friend class GlobalValue<self_type>;
 
-        struct Agent : public turbo::LinkNode<Agent> {
-            Agent() : combiner(NULL) {}
+        struct AgentHandle;
 
-            ~Agent() {
-                if (combiner) {
-                    combiner->commit_and_erase(this);
-                    combiner = NULL;
-                }
-            }
-
-            void reset(const ElementTp &val, self_type *c) {
-                combiner = c;
-                element.store(val);
-            }
+        struct Agent {
+            Agent(self_type *c, AgentHandle *h)
+                    : combiner(c), handle(h), next(nullptr), retired(false) {}
 
             // Call op(GlobalValue<Combiner> &, ElementTp &) to merge tls element
             // into global_result. The common impl. is:
@@ -206,16 +331,36 @@ namespace tally::detail {
             }
 
             self_type *combiner;
+            // Slot of the owning thread, cleared when the combiner is
+            // destroyed before the thread exits.
+            AgentHandle *handle;
+            std::atomic<Agent *> next;
+            // Set by the owning thread at exit.
+            std::atomic<bool> retired;
             ElementContainer<ElementTp> element;
         };
 
-        typedef detail::AgentGroup<Agent> AgentGroup;
+        // What AgentGroup keeps per thread.
+        struct AgentHandle {
+            AgentHandle() : agent(nullptr) {}
+
+            ~AgentHandle() {
+                if (agent) {
+                    agent->combiner->retire(agent);
+                    agent = nullptr;
+                }
+            }
+
+            Agent *agent;
+        };
+
+        typedef detail::AgentGroup<AgentHandle> AgentGroup;
 
         explicit AgentCombiner(const ResultTp result_identity = ResultTp(),
                                const ElementTp element_identity = ElementTp(),
                                const BinaryOp &op = BinaryOp())
                 : _id(AgentGroup::create_new_agent()), _op(op), _global_result(result_identity),
-                  _result_identity(result_identity), _element_identity(element_identity) {
+                  _result_identity(result_identity), _element_identity(element_identity), _head(nullptr) {
         }
 
         ~AgentCombiner() {
@@ -230,10 +375,11 @@ namespace tally::detail {
         ResultTp combine_agents() const {
             ElementTp tls_value;
             std::unique_lock guard(_lock);
+            reclaim_retired_agents();
             ResultTp ret = _global_result;
-            for (turbo::LinkNode<Agent> *node = _agents.head();
-                 node != _agents.end(); node = node->next()) {
-                node->value()->element.load(&tls_value);
+            for (Agent *agent = _head.load(std::memory_order_acquire); agent != nullptr;
+                 agent = agent->next.load(std::memory_order_acquire)) {
+                agent->element.load(&tls_value);
                 call_op_returning_void(_op, ret, tls_value);
             }
             return ret;
@@ -247,28 +393,40 @@ namespace tally::detail {
         ResultTp reset_all_agents() {
             ElementTp prev;
             std::unique_lock guard(_lock);
+            reclaim_retired_agents();
             ResultTp tmp = _global_result;
             _global_result = _result_identity;
-            for (turbo::LinkNode<Agent> *node = _agents.head();
-                 node != _agents.end(); node = node->next()) {
-                node->value()->element.exchange(&prev, _element_identity);
-                call_op_returning_void(_op, tmp, prev);
+            Agent *const head = _head.load(std::memory_order_acquire);
+            if constexpr (has_exclusive_exchange<ElementContainer<ElementTp>>::value) {
+                if (head == nullptr) {
+                    return tmp;
+                }
+                for (Agent *agent = head; agent != nullptr;
+                     agent = agent->next.load(std::memory_order_acquire)) {
+                    agent->element.begin_exclusive();
+                }
+                AsymmetricFence::heavy();
+                for (Agent *agent = head; agent != nullptr;
+                     agent = agent->next.load(std::memory_order_acquire)) {
+                    agent->element.exchange_exclusive(&prev, _element_identity);
+                    call_op_returning_void(_op, tmp, prev);
+                }
+            } else {
+                for (Agent *agent = head; agent != nullptr;
+                     agent = agent->next.load(std::memory_order_acquire)) {
+                    agent->element.exchange(&prev, _element_identity);
+                    call_op_returning_void(_op, tmp, prev);
+                }
             }
             return tmp;
         }
 
-        // Always called from the thread owning the agent.
-        void commit_and_erase(Agent *agent) {
-            if (NULL == agent) {
-                return;
-            }
-            ElementTp local;
+        // [Threadsafe] Apply `op' to the global result directly, for values
+        // which don't fit in tls elements.
+        template<typename Op, typename T1>
+        void modify_global(const Op &op, const T1 &value2) {
             std::unique_lock guard(_lock);
-            // TODO: For non-atomic types, we can pass the reference to op directly.
-            // But atomic types cannot. The code is a little troublesome to write.
-            agent->element.load(&local);
-            call_op_returning_void(_op, _global_result, local);
-            agent->RemoveFromList();
+            call_op_returning_void(op, _global_result, value2);
         }
 
         // Always called from the thread owning the agent
@@ -284,38 +442,52 @@ namespace tally::detail {
 
         // We need this function to be as fast as possible.
         inline Agent *get_or_create_tls_agent() {
-            Agent *agent = AgentGroup::get_tls_agent(_id);
-            if (!agent) {
-                // Create the agent
-                agent = AgentGroup::get_or_create_tls_agent(_id);
-                if (NULL == agent) {
-                    KLOG(FATAL) << "Fail to create agent";
-                    return NULL;
-                }
+            AgentHandle *handle = AgentGroup::get_tls_agent(_id);
+            if (handle && handle->agent) {
+                return handle->agent;
+            }
+            // Create the agent
+            handle = AgentGroup::get_or_create_tls_agent(_id);
+            if (NULL == handle) {
+                KLOG(FATAL) << "Fail to create agent";
+                return NULL;
             }
-            if (agent->combiner) {
-                return agent;
+            if (handle->agent) {
+                return handle->agent;
+            }
+            Agent *agent = new(std::nothrow) Agent(this, handle);
+            if (NULL == agent) {
+                KLOG(FATAL) << "Fail to create agent";
+                return NULL;
             }
-            agent->reset(_element_identity, this);
-            // TODO: Is uniqueness-checking necessary here?
-            {
-                std::unique_lock guard(_lock);
-                _agents.Append(agent);
+            // Not published yet, no other thread can touch the element.
+            agent->element.init(_element_identity);
+            Agent *head = _head.load(std::memory_order_relaxed);
+            do {
+                agent->next.store(head, std::memory_order_relaxed);
+            } while (!_head.compare_exchange_weak(head, agent, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+            handle->agent = agent;
+            // Bound retired agents of combiners which are never read, without
+            // waiting for a reader.
+            if (_lock.try_lock()) {
+                reclaim_retired_agents();
+                _lock.unlock();
             }
             return agent;
         }
 
         void clear_all_agents() {
             std::unique_lock guard(_lock);
-            // reseting agents is must because the agent object may be reused.
-            // Set element to be default-constructed so that if it's non-pod,
-            // internal allocations should be released.
-            for (turbo::LinkNode<Agent> *
-                    node = _agents.head(); node != _agents.end();) {
-                node->value()->reset(ElementTp(), NULL);
-                turbo::LinkNode<Agent> *const saved_next = node->next();
-                node->RemoveFromList();
-                node = saved_next;
+            Agent *agent = _head.exchange(nullptr, std::memory_order_acquire);
+            while (agent != nullptr) {
+                Agent *const saved_next = agent->next.load(std::memory_order_relaxed);
+                // The handle is gone with its thread once the agent retired.
+                if (!agent->retired.load(std::memory_order_acquire)) {
+                    agent->handle->agent = nullptr;
+                }
+                delete agent;
+                agent = saved_next;
             }
         }
 
@@ -324,14 +496,49 @@ namespace tally::detail {
         bool valid() const { return _id >= 0; }
 
     private:
+        // Always called from the thread owning the agent, at its exit.
+        void retire(Agent *agent) {
+            agent->retired.store(true, std::memory_order_release);
+        }
+
+        // Called with `_lock' held. Values of retired agents are moved into
+        // `_global_result', which does not change the combined value.
+        void reclaim_retired_agents() const {
+            std::atomic<Agent *> *link = &_head;
+            Agent *agent = _head.load(std::memory_order_acquire);
+            while (agent != nullptr) {
+                Agent *const next = agent->next.load(std::memory_order_acquire);
+                if (!agent->retired.load(std::memory_order_acquire)) {
+                    link = &agent->next;
+                    agent = next;
+                    continue;
+                }
+                // The head may be replaced by a new agent at any time.
+                if (link == &_head) {
+                    Agent *expected = agent;
+                    if (!_head.compare_exchange_strong(expected, next, std::memory_order_acquire)) {
+                        link = &agent->next;
+                        agent = next;
+                        continue;
+                    }
+                } else {
+                    link->store(next, std::memory_order_relaxed);
+                }
+                ElementTp local;
+                agent->element.load(&local);
+                call_op_returning_void(_op, _global_result, local);
+                delete agent;
+                agent = next;
+            }
+        }
+
         AgentId _id;
         BinaryOp _op;
         mutable std::mutex _lock;
-        ResultTp _global_result;
+        mutable ResultTp _global_result;
         ResultTp _result_identity;
         ElementTp _element_identity;
-        turbo::LinkedList<Agent> _agents;
+        mutable std::atomic<Agent *> _head;
     };
 
 }  // namespace tally::detail
-
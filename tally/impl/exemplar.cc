@@ -0,0 +1,109 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/impl/exemplar.h>
+#include <string.h>                     // memcpy
+#include <turbo/log/logging.h>
+
+namespace tally::detail {
+
+    ExemplarStore::ExemplarStore(size_t num_buckets)
+            : _num_buckets(num_buckets),
+              _combiner(Slots(num_buckets), Slots(num_buckets)) {
+    }
+
+    bool ExemplarStore::update(size_t index, double value,
+                               const turbo::flat_hash_map<std::string, std::string> &labels) {
+        if (TURBO_UNLIKELY(index >= _num_buckets)) {
+            return false;
+        }
+        size_t length = 0;
+        for (auto &it: labels) {
+            length += it.first.size() + it.second.size();
+        }
+        if (length > MAX_LABELS_LENGTH ||
+            length + 2 * labels.size() > sizeof(Slot::labels)) {
+            return false;
+        }
+        auto *agent = _combiner.get_or_create_tls_agent();
+        if (TURBO_UNLIKELY(agent == nullptr)) {
+            KLOG(FATAL) << "Fail to create agent";
+            return false;
+        }
+        agent->element.modify(UpdateSlot(), Update{index, value, &labels});
+        return true;
+    }
+
+    bool ExemplarStore::collect(std::vector<std::optional<Exemplar>> *out) const {
+        const Slots newest = _combiner.combine_agents();
+        bool found = false;
+        out->clear();
+        out->resize(_num_buckets);
+        for (size_t i = 0; i < _num_buckets; ++i) {
+            const Slot &slot = newest[i];
+            if (slot.timestamp_us == 0) {
+                continue;
+            }
+            Exemplar e;
+            e.value = slot.value;
+            e.timestamp = turbo::Time::from_microseconds(slot.timestamp_us);
+            const char *p = slot.labels;
+            const char *const end = slot.labels + slot.labels_size;
+            while (p < end) {
+                std::string name(p);
+                p += name.size() + 1;
+                std::string value(p);
+                p += value.size() + 1;
+                e.labels[std::move(name)] = std::move(value);
+            }
+            (*out)[i] = std::move(e);
+            found = true;
+        }
+        if (!found) {
+            out->clear();
+        }
+        return found;
+    }
+
+    void ExemplarStore::UpdateSlot::operator()(Slots &slots, const Update &update) const {
+        Slot &slot = slots[update.index];
+        char *p = slot.labels;
+        for (auto &it: *update.labels) {
+            memcpy(p, it.first.data(), it.first.size());
+            p += it.first.size();
+            *p++ = '\0';
+            memcpy(p, it.second.data(), it.second.size());
+            p += it.second.size();
+            *p++ = '\0';
+        }
+        slot.labels_size = static_cast<uint32_t>(p - slot.labels);
+        slot.value = update.value;
+        slot.timestamp_us = turbo::Time::current_microseconds();
+    }
+
+    void ExemplarStore::KeepNewer::operator()(Slots &lhs, const Slots &rhs) const {
+        for (size_t i = 0; i < lhs.size() && i < rhs.size(); ++i) {
+            const Slot &src = rhs[i];
+            Slot &dst = lhs[i];
+            if (src.timestamp_us > dst.timestamp_us) {
+                dst.timestamp_us = src.timestamp_us;
+                dst.value = src.value;
+                dst.labels_size = src.labels_size;
+                memcpy(dst.labels, src.labels, src.labels_size);
+            }
+        }
+    }
+
+}  // namespace tally::detail
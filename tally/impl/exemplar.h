@@ -0,0 +1,82 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <stdint.h>                     // uint32_t
+#include <optional>                     // std::optional
+#include <vector>                       // std::vector
+#include <tally/impl/combiner.h>        // detail::AgentCombiner
+#include <tally/variable.h>             // Exemplar
+
+namespace tally::detail {
+
+    // Keeps the latest exemplar of each bucket of a histogram.
+    // Every thread keeps a row of slots in its agent, which is only
+    // contended while the exemplars are collected.
+    class ExemplarStore {
+    public:
+        // OpenMetrics limits the combined length of label names and values
+        // of an exemplar to 128 characters.
+        static constexpr size_t MAX_LABELS_LENGTH = 128;
+
+        explicit ExemplarStore(size_t num_buckets);
+
+        size_t num_buckets() const { return _num_buckets; }
+
+        // Replace the exemplar of bucket `index' in the slots of calling
+        // thread. Returns false if `labels' is too long to be kept.
+        bool update(size_t index, double value,
+                    const turbo::flat_hash_map<std::string, std::string> &labels);
+
+        // Put the newest exemplar of each bucket among all threads into `out'.
+        // Returns false if no exemplar was ever recorded.
+        bool collect(std::vector<std::optional<Exemplar>> *out) const;
+
+    private:
+        struct Slot {
+            int64_t timestamp_us{0};    // 0 means empty
+            double value{0};
+            uint32_t labels_size{0};
+            // name\0value\0name\0value\0...
+            char labels[MAX_LABELS_LENGTH * 3];
+        };
+
+        typedef std::vector<Slot> Slots;
+
+        struct Update {
+            size_t index;
+            double value;
+            const turbo::flat_hash_map<std::string, std::string> *labels;
+        };
+
+        // Write an exemplar into its slot of a row.
+        struct UpdateSlot {
+            void operator()(Slots &slots, const Update &update) const;
+        };
+
+        // Keep the newer exemplar of each pair of slots.
+        struct KeepNewer {
+            void operator()(Slots &lhs, const Slots &rhs) const;
+        };
+
+        typedef AgentCombiner<Slots, Slots, KeepNewer> combiner_type;
+
+    private:
+        size_t _num_buckets;
+        combiner_type _combiner;
+    };
+
+}  // namespace tally::detail
@@ -18,67 +18,39 @@
 
 namespace tally::detail {
 
-    inline uint32_t ones32(uint32_t x) {
-        /* 32-bit recursive reduction using SWAR...
-         * but first step is mapping 2-bit values
-         * into sum of 2 1-bit values in sneaky way
-         */
-        x -= ((x >> 1) & 0x55555555);
-        x = (((x >> 2) & 0x33333333) + (x & 0x33333333));
-        x = (((x >> 4) + x) & 0x0f0f0f0f);
-        x += (x >> 8);
-        x += (x >> 16);
-        return (x & 0x0000003f);
-    }
-
-    inline uint32_t log2(uint32_t x) {
-        int y = (x & (x - 1));
-        y |= -y;
-        y >>= 31;
-        x |= (x >> 1);
-        x |= (x >> 2);
-        x |= (x >> 4);
-        x |= (x >> 8);
-        x |= (x >> 16);
-        return (ones32(x) - 1 - y);
-    }
-
-    inline size_t get_interval_index(int64_t &x) {
-        if (x <= 2) {
-            return 0;
-        } else if (x > std::numeric_limits<uint32_t>::max()) {
-            x = std::numeric_limits<uint32_t>::max();
-            return 31;
-        } else {
-            return log2(x) - 1;
-        }
-    }
-
     class AddLatency {
     public:
-        AddLatency(int64_t latency) : _latency(latency) {}
+        AddLatency(int64_t latency, IntervalQueue *pending) : _latency(latency), _pending(pending) {}
 
         void operator()(GlobalValue<Percentile::combiner_type> &global_value,
                         ThreadLocalPercentileSamples &local_value) const {
-            // Copy to latency since get_interval_index may change input.
-            int64_t latency = _latency;
-            const size_t index = get_interval_index(latency);
+            const size_t index = get_interval_index(_latency);
             PercentileInterval<ThreadLocalPercentileSamples::SAMPLE_SIZE> &
                     interval = local_value.get_interval_at(index);
             if (interval.full()) {
-                GlobalPercentileSamples *g = global_value.lock();
-                g->get_interval_at(index).merge(interval);
-                g->_num_added += interval.added_count();
-                global_value.unlock();
+                if (!_pending->push(index, interval)) {
+                    GlobalPercentileSamples *g = global_value.lock();
+                    _pending->merge_into(g);
+                    g->get_interval_at(index).merge(interval);
+                    g->_num_added += interval.added_count();
+                    global_value.unlock();
+                }
                 local_value._num_added -= interval.added_count();
                 interval.clear();
             }
-            interval.add64(latency);
+            interval.add32(encode_sample(_latency, index));
             ++local_value._num_added;
         }
 
     private:
         int64_t _latency;
+        IntervalQueue *_pending;
+    };
+
+    struct MergePending {
+        void operator()(GlobalPercentileSamples &g, IntervalQueue *pending) const {
+            pending->merge_into(&g);
+        }
     };
 
     Percentile::Percentile() : _combiner(nullptr), _sampler(nullptr) {
@@ -95,11 +67,19 @@ namespace tally::detail {
         delete _combiner;
     }
 
+    void Percentile::merge_pending() const {
+        if (!_pending.empty()) {
+            _combiner->modify_global(MergePending(), &_pending);
+        }
+    }
+
     Percentile::value_type Percentile::reset() {
+        merge_pending();
         return _combiner->reset_all_agents();
     }
 
     Percentile::value_type Percentile::get_value() const {
+        merge_pending();
         return _combiner->combine_agents();
     }
 
@@ -110,9 +90,6 @@ namespace tally::detail {
             return *this;
         }
         if (latency < 0) {
-            // we don't check overflow(of uint32) in percentile because the
-            // overflowed value which is included in last range does not affect
-            // overall distribution of other values too much.
             if (!_debug_name.empty()) {
                 KLOG(WARNING) << "Input=" << latency << " to `" << _debug_name
                              << "' is negative, drop";
@@ -122,7 +99,7 @@ namespace tally::detail {
             }
             return *this;
         }
-        agent->merge_global(AddLatency(latency));
+        agent->merge_global(AddLatency(latency, &_pending));
         return *this;
     }
 
@@ -21,6 +21,7 @@
 #include <ostream>                      // std::ostream
 #include <algorithm>                    // std::sort
 #include <cmath>                       // ceil
+#include <atomic>
 #include <tally/impl/reducer.h>               // Reducer
 #include <tally/window.h>                // Window
 #include <tally/impl/combiner.h>       // AgentCombiner
@@ -45,6 +46,14 @@ namespace tally::detail {
                 : _num_added(0), _sorted(false), _num_samples(0) {
         }
 
+        // Sort ahead, after which get_sample_at() only reads.
+        void sort() {
+            if (!_sorted) {
+                std::sort(_samples, _samples + _num_samples);
+                _sorted = true;
+            }
+        }
+
         // Get index-th sample in ascending order.
         uint32_t get_sample_at(size_t index) {
             const size_t saved_num = _num_samples;
@@ -222,17 +231,58 @@ namespace tally::detail {
         uint32_t _samples[SAMPLE_SIZE];
     };
 
-    static const size_t NUM_INTERVALS = 32;
+    // Intervals of latencies up to 2^42, which is 73 minutes in
+    // nanoseconds or 50 days in microseconds. Every PercentileSamples has an
+    // array of NUM_INTERVALS pointers, so intervals are not extended to the
+    // whole int64_t range. Larger latencies are taken as MAX_LATENCY.
+    static const size_t NUM_INTERVALS = 42;
+    static const int64_t MAX_LATENCY = int64_t(1) << NUM_INTERVALS;
+
+    // Index of the interval that latency `x' falls in, namely
+    // ceil(log2(x)) - 1.
+    inline size_t get_interval_index(int64_t x) {
+        if (x <= 2) {
+            return 0;
+        } else if (x >= MAX_LATENCY) {
+            return NUM_INTERVALS - 1;
+        } else {
+            return 63 - __builtin_clzll(static_cast<uint64_t>(x - 1));
+        }
+    }
+
+    // Samples are stored as uint32_t. Latencies of the intervals below 31
+    // are exact, the ones above keep their 31 leading bits, which is
+    // precise enough for percentiles and keeps the intervals as small as
+    // they were.
+    inline uint32_t interval_shift(size_t index) {
+        return index < 31 ? 0 : index - 30;
+    }
+
+    inline uint32_t encode_sample(int64_t x, size_t index) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(std::min(x, MAX_LATENCY)) >> interval_shift(index));
+    }
+
+    inline int64_t decode_sample(uint32_t sample, size_t index) {
+        return static_cast<int64_t>(static_cast<uint64_t>(sample) << interval_shift(index));
+    }
 
 // This declartion is a must for gcc 3.4
     class AddLatency;
 
+    class AddLatencyStats;
+
+    class IntervalQueue;
+
 // Group of PercentileIntervals.
     template<size_t SAMPLE_SIZE_IN>
     class PercentileSamples {
     public:
         friend class AddLatency;
 
+        friend class AddLatencyStats;
+
+        friend class IntervalQueue;
+
         static const size_t SAMPLE_SIZE = SAMPLE_SIZE_IN;
 
         PercentileSamples() {
@@ -282,7 +332,7 @@ namespace tally::detail {
         // stable as current impl. CDF plotted by the method changes dramatically
         // from seconds to seconds. It seems that separating intervals probably
         // keep more long-tail values.
-        uint32_t get_number(double ratio) {
+        int64_t get_number(double ratio) {
             size_t n = (size_t) ceil(ratio * _num_added);
             if (n > _num_added) {
                 n = _num_added;
@@ -297,12 +347,22 @@ namespace tally::detail {
                 if (n <= invl.added_count()) {
                     size_t sample_n = n * invl.sample_count() / invl.added_count();
                     size_t sample_index = (sample_n ? sample_n - 1 : 0);
-                    return invl.get_sample_at(sample_index);
+                    return decode_sample(invl.get_sample_at(sample_index), i);
                 }
                 n -= invl.added_count();
             }
             KCHECK(false) << "Can't reach here";
-            return std::numeric_limits<uint32_t>::max();
+            return std::numeric_limits<int64_t>::max();
+        }
+
+        // Sort all intervals, after which get_number() only reads and can be
+        // called from multiple threads.
+        void sort() {
+            for (size_t i = 0; i < NUM_INTERVALS; ++i) {
+                if (_intervals[i]) {
+                    _intervals[i]->sort();
+                }
+            }
         }
 
         // Add samples in another PercentileSamples.
@@ -437,6 +497,129 @@ namespace tally::detail {
     typedef PercentileSamples<254> GlobalPercentileSamples;
     typedef PercentileSamples<30> ThreadLocalPercentileSamples;
 
+    // Full intervals of ThreadLocalPercentileSamples published by writers
+    // and merged into global samples by readers, so that writers don't
+    // contend on the lock of the combiner when their intervals fill up.
+    // Intervals are copied into slots of a per-queue pool, which grows by
+    // chunks up to MAX_PENDING slots and is never shrunk, so that recording
+    // doesn't allocate once the pool has grown to the peak. Pushing is
+    // lock-free. Once no slot is free, which bounds the memory when nobody
+    // reads, writers merge by themselves. merge_into() must be serialized
+    // by the caller, e.g. by the lock of the combiner.
+    class IntervalQueue {
+    public:
+        typedef PercentileInterval<ThreadLocalPercentileSamples::SAMPLE_SIZE> interval_type;
+
+        static const size_t MAX_PENDING = 256;
+
+        IntervalQueue() : _pending(0), _hint(0) {
+            for (auto &c: _chunks) {
+                c.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        ~IntervalQueue() {
+            for (auto &c: _chunks) {
+                delete c.load(std::memory_order_acquire);
+            }
+        }
+
+        IntervalQueue(const IntervalQueue &) = delete;
+        IntervalQueue &operator=(const IntervalQueue &) = delete;
+
+        // Publish a copy of `interval' at `index'. Returns false if too many
+        // intervals are pending, in which case the caller should merge the
+        // queue along with `interval' by itself.
+        bool push(size_t index, const interval_type &interval) {
+            if (_pending.load(std::memory_order_relaxed) >= MAX_PENDING) {
+                return false;
+            }
+            Slot *slot = acquire_slot();
+            if (slot == nullptr) {
+                return false;
+            }
+            _pending.fetch_add(1, std::memory_order_relaxed);
+            slot->index = index;
+            slot->interval = interval;
+            slot->state.store(SLOT_READY, std::memory_order_release);
+            return true;
+        }
+
+        // Merge all pending intervals into `samples'.
+        template<size_t size>
+        void merge_into(PercentileSamples<size> *samples) {
+            for (auto &c: _chunks) {
+                Chunk *chunk = c.load(std::memory_order_acquire);
+                if (chunk == nullptr) {
+                    break;
+                }
+                for (auto &slot: chunk->slots) {
+                    if (slot.state.load(std::memory_order_acquire) != SLOT_READY) {
+                        continue;
+                    }
+                    samples->get_interval_at(slot.index).merge(slot.interval);
+                    samples->_num_added += slot.interval.added_count();
+                    slot.state.store(SLOT_FREE, std::memory_order_release);
+                    _pending.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool empty() const { return _pending.load(std::memory_order_relaxed) == 0; }
+
+    private:
+        enum : uint8_t {
+            SLOT_FREE = 0,
+            SLOT_WRITING = 1,
+            SLOT_READY = 2,
+        };
+
+        static const size_t CHUNK_SIZE = 32;
+        static const size_t NUM_CHUNKS = MAX_PENDING / CHUNK_SIZE;
+
+        struct Slot {
+            std::atomic<uint8_t> state{SLOT_FREE};
+            size_t index{0};
+            interval_type interval;
+        };
+
+        struct Chunk {
+            Slot slots[CHUNK_SIZE];
+        };
+
+        // Claim a free slot, growing the pool if the existing chunks are
+        // taken. Returns nullptr if all MAX_PENDING slots are taken.
+        Slot *acquire_slot() {
+            // Writers start at different slots to not race on the same ones.
+            const size_t start = _hint.fetch_add(1, std::memory_order_relaxed);
+            for (auto &c: _chunks) {
+                Chunk *chunk = c.load(std::memory_order_acquire);
+                if (chunk == nullptr) {
+                    Chunk *created = new Chunk;
+                    if (c.compare_exchange_strong(chunk, created, std::memory_order_acq_rel)) {
+                        chunk = created;
+                    } else {
+                        delete created;
+                    }
+                }
+                for (size_t i = 0; i < CHUNK_SIZE; ++i) {
+                    Slot &slot = chunk->slots[(start + i) % CHUNK_SIZE];
+                    uint8_t expected = SLOT_FREE;
+                    if (slot.state.load(std::memory_order_relaxed) == SLOT_FREE &&
+                        slot.state.compare_exchange_strong(expected, SLOT_WRITING,
+                                                           std::memory_order_acquire)) {
+                        return &slot;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        std::atomic<Chunk *> _chunks[NUM_CHUNKS];
+        std::atomic<size_t> _pending;
+        std::atomic<size_t> _hint;
+    };
+
     // A specialized reducer for finding the percentile of latencies.
     // NOTE: DON'T use it directly, use LatencyRecorder instead.
     class Percentile {
@@ -491,8 +674,12 @@ namespace tally::detail {
         }
 
     private:
+        // Merge intervals published by writers into the global samples.
+        void merge_pending() const;
+
         combiner_type *_combiner;
         sampler_type *_sampler;
+        mutable IntervalQueue _pending;
         std::string _debug_name;
     };
 
@@ -0,0 +1,118 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#include <tally/impl/combiner.h>
+
+namespace tally::detail {
+
+    // Index of the cpu running the calling thread. glibc 2.35+ reads it from
+    // the restartable sequence area registered for every thread, older ones
+    // from the vDSO. The thread may be migrated right after, so the result
+    // is only a hint for spreading writers.
+    inline unsigned current_cpu() {
+#if defined(__linux__)
+        const int cpu = sched_getcpu();
+        if (TURBO_LIKELY(cpu >= 0)) {
+            return static_cast<unsigned>(cpu);
+        }
+#endif
+        return static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    }
+
+    // Same interface as AgentCombiner but elements are sharded by cpu rather
+    // than by thread: memory is bounded by the number of cpus, and threads
+    // are never registered, which suits services spawning many short-lived
+    // threads. Threads on one cpu, or migrated in the middle of a
+    // modification, share an element, so ElementTp must be atomical and every
+    // modification is an atomic RMW on the element.
+    template<typename ResultTp, typename ElementTp, typename BinaryOp>
+    class PerCpuCombiner {
+        static_assert(is_atomical<ElementTp>::value, "elements shared by threads must be atomical");
+    public:
+        typedef ResultTp result_type;
+        typedef ElementTp element_type;
+
+        // Named after AgentCombiner::Agent so that Reducer works with both.
+        struct alignas(64) Agent {
+            ElementContainer<ElementTp> element;
+        };
+
+        explicit PerCpuCombiner(const ResultTp result_identity = ResultTp(),
+                                const ElementTp element_identity = ElementTp(),
+                                const BinaryOp &op = BinaryOp())
+                : _op(op), _result_identity(result_identity), _element_identity(element_identity),
+                  _num_agents(num_cpus()), _agents(new Agent[_num_agents]) {
+            for (size_t i = 0; i < _num_agents; ++i) {
+                _agents[i].element.store(element_identity);
+            }
+        }
+
+        // [Threadsafe] May be called from anywhere
+        ResultTp combine_agents() const {
+            ElementTp value;
+            ResultTp ret = _result_identity;
+            for (size_t i = 0; i < _num_agents; ++i) {
+                _agents[i].element.load(&value);
+                call_op_returning_void(_op, ret, value);
+            }
+            return ret;
+        }
+
+        typename add_cr_non_integral<ElementTp>::type element_identity() const { return _element_identity; }
+
+        typename add_cr_non_integral<ResultTp>::type result_identity() const { return _result_identity; }
+
+        // [Threadsafe] May be called from anywhere.
+        ResultTp reset_all_agents() {
+            ElementTp prev;
+            ResultTp ret = _result_identity;
+            for (size_t i = 0; i < _num_agents; ++i) {
+                _agents[i].element.exchange(&prev, _element_identity);
+                call_op_returning_void(_op, ret, prev);
+            }
+            return ret;
+        }
+
+        // The element of the current cpu. Never fails.
+        inline Agent *get_or_create_tls_agent() {
+            return &_agents[current_cpu() % _num_agents];
+        }
+
+        const BinaryOp &op() const { return _op; }
+
+        bool valid() const { return true; }
+
+    private:
+        static size_t num_cpus() {
+            const long n = sysconf(_SC_NPROCESSORS_CONF);
+            return n > 0 ? static_cast<size_t>(n) : 1;
+        }
+
+        BinaryOp _op;
+        ResultTp _result_identity;
+        ElementTp _element_identity;
+        const size_t _num_agents;
+        std::unique_ptr<Agent[]> _agents;
+    };
+
+}  // namespace tally::detail
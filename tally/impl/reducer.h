@@ -20,6 +20,7 @@
 #include <turbo/base/class_name.h>                      // class_name_str
 #include <tally/variable.h>                        // Variable
 #include <tally/impl/combiner.h>                 // detail::AgentCombiner
+#include <tally/impl/percpu_combiner.h>          // detail::PerCpuCombiner
 #include <tally/impl/sampler.h>                  // ReducerSampler
 #include <tally/impl/series.h>
 #include <tally/window.h>
@@ -62,10 +63,31 @@ namespace tally {
     // my_type_sum << MyType(1) << MyType(2) << MyType(3);
     // KLOG(INFO) << my_type_sum;  // "MyType{6}"
 
-    template<typename T, typename Op, typename InvOp = detail::VoidOp>
+    class LocalBatch;
+
+    // Where reducers keep values before combining, see Counter.
+    //   PerThreadAgents: an element per thread touching the reducer, the
+    //                    fastest to write, but every new thread allocates
+    //                    elements and every exiting thread commits them under
+    //                    a lock.
+    //   PerCpuAgents:    an element per cpu, written with atomic RMW. For
+    //                    services spawning many short-lived threads. Atomical
+    //                    values only.
+    struct PerThreadAgents {
+        template<typename T, typename Op>
+        using combiner_type = detail::AgentCombiner<T, T, Op>;
+    };
+
+    struct PerCpuAgents {
+        template<typename T, typename Op>
+        using combiner_type = detail::PerCpuCombiner<T, T, Op>;
+    };
+
+    template<typename T, typename Op, typename InvOp = detail::VoidOp,
+            typename Agents = PerThreadAgents>
     class Reducer : public Variable {
     public:
-        typedef typename detail::AgentCombiner<T, T, Op> combiner_type;
+        typedef typename Agents::template combiner_type<T, Op> combiner_type;
         typedef typename combiner_type::Agent agent_type;
         typedef detail::ReducerSampler<Reducer, T, Op, InvOp> sampler_type;
 
@@ -179,14 +201,16 @@ namespace tally {
         }
 
     private:
+        friend class LocalBatch;
+
         combiner_type _combiner;
         sampler_type *_sampler;
         SeriesSampler *_series_sampler;
         InvOp _inv_op;
     };
 
-    template<typename T, typename Op, typename InvOp>
-    inline Reducer<T, Op, InvOp> &Reducer<T, Op, InvOp>::operator<<(
+    template<typename T, typename Op, typename InvOp, typename Agents>
+    inline Reducer<T, Op, InvOp, Agents> &Reducer<T, Op, InvOp, Agents>::operator<<(
             typename add_cr_non_integral<T>::type value) {
         // It's wait-free for most time
         agent_type *agent = _combiner.get_or_create_tls_agent();
@@ -13,15 +13,22 @@
 // limitations under the License.
 //
 
-#include <turbo/memory/leaky_singleton.h>
 #include <tally/impl/reducer.h>
 #include <tally/impl/sampler.h>
 #include <tally/passive_status.h>
 #include <tally/window.h>
+#include <tally/counter.h>
+#include <tally/scope.h>
 #include <tally/config.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 namespace tally::detail {
 
+    // Missed ticks are warned at most once in so many seconds, they are
+    // counted by sampler_missed_ticks anyway.
     const int WARN_NOSLEEP_THRESHOLD = 2;
 
     // Combine two circular linked list into one.
@@ -55,10 +62,12 @@ namespace tally::detail {
     // deletion is taken place in the thread as well.
     class SamplerCollector : public Reducer<Sampler*, CombineSampler> {
     public:
-        SamplerCollector()
+        explicit SamplerCollector(int64_t period_us)
             : Reducer<Sampler*, CombineSampler>(VariableAttr::sampler_attr()), _created(false)
             , _stop(false)
-            , _cumulated_time_us(0) {
+            , _period_us(period_us)
+            , _cumulated_time_us(0)
+            , _next(nullptr) {
             create_sampling_thread();
         }
         ~SamplerCollector() {
@@ -69,16 +78,26 @@ namespace tally::detail {
             }
         }
 
+        // The collector ticking every `period_us', created on the first call.
+        // Collectors are never destroyed.
+        static SamplerCollector* get(int64_t period_us);
+
+        // Wake up all collectors to hand over samplers whose period changed.
+        static void wake_all();
+
     private:
         // Support for fork:
-        // * The singleton can be null before forking, the child callback will not
-        //   be registered.
-        // * If the singleton is not null before forking, the child callback will
-        //   be registered and the sampling thread will be re-created.
+        // * No collector is created before forking, the child callback will
+        //   not be registered.
+        // * If any collector is created before forking, the child callback
+        //   will be registered and the sampling threads will be re-created.
         // * A forked program can be forked again.
 
         static void child_callback_atfork() {
-            turbo::get_leaky_singleton<SamplerCollector>()->after_forked_as_child();
+            for (SamplerCollector* c = _s_head.load(std::memory_order_acquire);
+                 c != nullptr; c = c->_next) {
+                c->after_forked_as_child();
+            }
         }
 
         void create_sampling_thread() {
@@ -101,6 +120,10 @@ namespace tally::detail {
 
         void run();
 
+        // Take in newly scheduled samplers, delete destroyed ones, hand over
+        // ones of other periods and sample the rest at `tick_us' if `sampling'.
+        void visit(turbo::LinkNode<Sampler>* root, bool sampling, int64_t tick_us);
+
         static void* sampling_thread(void* arg) {
             //tally::PlatformThread::SetName("tally_sampler");
             static_cast<SamplerCollector*>(arg)->run();
@@ -114,59 +137,167 @@ namespace tally::detail {
     private:
         bool _created;
         bool _stop;
+        const int64_t _period_us;
         int64_t _cumulated_time_us;
         pthread_t _tid;
+        std::mutex _wake_mutex;
+        std::condition_variable _wake_cond;
+        bool _period_changed{false};
+        // Collectors of all periods, only prepended to.
+        SamplerCollector* _next;
+        static std::atomic<SamplerCollector*> _s_head;
+        static std::mutex _s_create_mutex;
     };
 
+    namespace {
+        int64_t monotonic_microseconds() {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        Counter<int64_t>* missed_ticks() {
+            static Counter<int64_t>* counter = new Counter<int64_t>(
+                    "sampler_missed_ticks", "sampling ticks skipped for the sampling thread was late",
+                    ScopeInstance::instance()->get_sys_scope().get());
+            return counter;
+        }
+    }  // namespace
+
+    std::atomic<SamplerCollector*> SamplerCollector::_s_head{nullptr};
+    std::mutex SamplerCollector::_s_create_mutex;
+
+    SamplerCollector* SamplerCollector::get(int64_t period_us) {
+        for (SamplerCollector* c = _s_head.load(std::memory_order_acquire);
+             c != nullptr; c = c->_next) {
+            if (c->_period_us == period_us) {
+                return c;
+            }
+        }
+        std::unique_lock lk(_s_create_mutex);
+        for (SamplerCollector* c = _s_head.load(std::memory_order_acquire);
+             c != nullptr; c = c->_next) {
+            if (c->_period_us == period_us) {
+                return c;
+            }
+        }
+        SamplerCollector* c = new SamplerCollector(period_us);
+        c->_next = _s_head.load(std::memory_order_relaxed);
+        _s_head.store(c, std::memory_order_release);
+        lk.unlock();
+        // Exposed along with the first collector. Not under the lock since
+        // exposing may schedule samplers.
+        missed_ticks();
+        return c;
+    }
+
+
+    void SamplerCollector::visit(turbo::LinkNode<Sampler>* root, bool sampling, int64_t tick_us) {
+        Sampler* s = this->reset();
+        if (s) {
+            s->InsertBeforeAsList(root);
+        }
+        for (turbo::LinkNode<Sampler>* p = root->next(); p != root;) {
+            // We may remove p from the list, save next first.
+            turbo::LinkNode<Sampler>* saved_next = p->next();
+            Sampler* s = p->value();
+            s->_mutex.lock();
+            if (!s->_used) {
+                s->_mutex.unlock();
+                p->RemoveFromList();
+                delete s;
+            } else if (s->_period_us != _period_us) {
+                // The sampling period was changed, move to the collector
+                // of the new period.
+                const int64_t period_us = s->_period_us;
+                s->_mutex.unlock();
+                p->RemoveFromList();
+                *get(period_us) << s;
+            } else {
+                if (sampling) {
+                    s->_tick_us = tick_us;
+                    s->take_sample();
+                    s->_tick_us = 0;
+                }
+                s->_mutex.unlock();
+            }
+            p = saved_next;
+        }
+    }
+
+    void SamplerCollector::wake_all() {
+        for (SamplerCollector* c = _s_head.load(std::memory_order_acquire);
+             c != nullptr; c = c->_next) {
+            std::unique_lock lk(c->_wake_mutex);
+            c->_period_changed = true;
+            c->_wake_cond.notify_one();
+        }
+    }
+
 
     void SamplerCollector::run() {
         ::usleep(turbo::get_flag(FLAGS_tally_sampler_thread_start_delay_us));
 
         turbo::LinkNode<Sampler> root;
-        int consecutive_nosleep = 0;
+        // Ticks are at multiples of the period in wall clock, so that samples
+        // of different processes line up. Deadlines are kept in the monotonic
+        // clock to be immune to clock adjustments, and the mapping is
+        // re-aligned if the wall clock steps.
+        int64_t tick_us = 0;
+        int64_t deadline = 0;
+        auto align = [&] {
+            const int64_t real_now = turbo::Time::current_microseconds();
+            const int64_t mono_now = monotonic_microseconds();
+            tick_us = (real_now / _period_us + 1) * _period_us;
+            deadline = mono_now + (tick_us - real_now);
+        };
+        align();
+        int64_t missed_since_warn = 0;
+        int64_t last_warn = 0;
         while (!_stop) {
-            int64_t abstime = turbo::Time::current_microseconds();
-            Sampler* s = this->reset();
-            if (s) {
-                s->InsertBeforeAsList(&root);
-            }
-            for (turbo::LinkNode<Sampler>* p = root.next(); p != &root;) {
-                // We may remove p from the list, save next first.
-                turbo::LinkNode<Sampler>* saved_next = p->next();
-                Sampler* s = p->value();
-                s->_mutex.lock();
-                if (!s->_used) {
-                    s->_mutex.unlock();
-                    p->RemoveFromList();
-                    delete s;
-                } else {
-                    s->take_sample();
-                    s->_mutex.unlock();
+            int64_t now = monotonic_microseconds();
+            while (deadline > now) {
+                std::unique_lock lk(_wake_mutex);
+                _wake_cond.wait_until(lk, std::chrono::steady_clock::time_point(std::chrono::microseconds(deadline)),
+                                      [this] { return _period_changed; });
+                if (_period_changed) {
+                    // Hand over samplers of other periods without waiting
+                    // for the next tick, which is up to a second later.
+                    _period_changed = false;
+                    lk.unlock();
+                    visit(&root, false, 0);
                 }
-                p = saved_next;
+                now = monotonic_microseconds();
             }
-            bool slept = false;
-            int64_t now = turbo::Time::current_microseconds();
-            _cumulated_time_us += now - abstime;
-            abstime += 1000000L;
-            while (abstime > now) {
-                ::usleep(abstime - now);
-                slept = true;
-                now = turbo::Time::current_microseconds();
-            }
-            if (slept) {
-                consecutive_nosleep = 0;
-            } else {
-                if (++consecutive_nosleep >= WARN_NOSLEEP_THRESHOLD) {
-                    consecutive_nosleep = 0;
-                    KLOG(WARNING) << "tally is busy at sampling for "
-                                 << WARN_NOSLEEP_THRESHOLD << " seconds!";
+            visit(&root, true, tick_us);
+            const int64_t end = monotonic_microseconds();
+            _cumulated_time_us += end - now;
+
+            tick_us += _period_us;
+            deadline += _period_us;
+            if (end >= deadline) {
+                // Skip the ticks we are late for instead of sampling in a
+                // burst, the samples next to the gap cover it by their stamps.
+                const int64_t missed = (end - deadline) / _period_us + 1;
+                tick_us += missed * _period_us;
+                deadline += missed * _period_us;
+                *missed_ticks() << missed;
+                missed_since_warn += missed;
+                if (end - last_warn >= WARN_NOSLEEP_THRESHOLD * 1000000L) {
+                    KLOG(WARNING) << "tally is busy at sampling, missed " << missed_since_warn
+                                  << " ticks of " << _period_us << "us";
+                    missed_since_warn = 0;
+                    last_warn = end;
                 }
             }
+            const int64_t skew = (turbo::Time::current_microseconds() - tick_us) -
+                                 (monotonic_microseconds() - deadline);
+            if (skew > _period_us / 2 || skew < -_period_us / 2) {
+                align();
+            }
         }
     }
 
-    Sampler::Sampler() : _used(true) {}
+    Sampler::Sampler() : _used(true), _period_us(DEFAULT_PERIOD_US), _tick_us(0) {}
 
     Sampler::~Sampler() {}
 
@@ -174,8 +305,29 @@ namespace tally::detail {
         // since the SamplerCollector is initialized before the program starts
         // flags will not take effect if used in the SamplerCollector constructor
         if (turbo::get_flag(FLAGS_tally_enable_sampling)) {
-            *turbo::get_leaky_singleton<SamplerCollector>() << this;
+            *SamplerCollector::get(sampling_period_us()) << this;
+        }
+    }
+
+    int Sampler::set_sampling_period_us(int64_t period_us) {
+        if (period_us < MIN_PERIOD_US || period_us > DEFAULT_PERIOD_US ||
+            DEFAULT_PERIOD_US % period_us != 0) {
+            KLOG(ERROR) << "Invalid sampling period=" << period_us << "us";
+            return -1;
+        }
+        std::unique_lock lk(_mutex);
+        if (period_us == _period_us.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        if (!period_changeable()) {
+            KLOG(ERROR) << "Sampling period is fixed at " << _period_us << "us";
+            return -1;
         }
+        _period_us.store(period_us, std::memory_order_relaxed);
+        on_period_changed();
+        lk.unlock();
+        SamplerCollector::wake_all();
+        return 0;
     }
 
     void Sampler::destroy() {
@@ -15,6 +15,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <type_traits>
 #include <vector>
 #include <turbo/container/linked_list.h>
 #include <turbo/log/logging.h>               // KLOG()
@@ -22,6 +25,7 @@
 #include <tally/utility/type_traits.h>           // is_same
 #include <turbo/base/class_name.h>
 #include <mutex>
+#include <tally/impl/sliding_window.h>
 
 namespace tally::detail {
 
@@ -38,16 +42,30 @@ namespace tally::detail {
     // The base class for all samplers whose take_sample() are called periodically.
     class Sampler : public turbo::LinkNode<Sampler> {
     public:
+        static constexpr int64_t DEFAULT_PERIOD_US = 1000000;
+        static constexpr int64_t MIN_PERIOD_US = 1000;
+
         Sampler();
 
-        // This function will be called every second(approximately) in a
-        // dedicated thread if schedule() is called.
+        // This function will be called every sampling period(approximately)
+        // in a dedicated thread if schedule() is called.
         virtual void take_sample() = 0;
 
         // Register this sampler globally so that take_sample() will be called
         // periodically.
         void schedule();
 
+        // Samplers of the same period are called by the same thread, one
+        // second by default.
+        int64_t sampling_period_us() const {
+            return _period_us.load(std::memory_order_relaxed);
+        }
+
+        // The period must divide one second and be no less than
+        // MIN_PERIOD_US. A scheduled sampler moves to the thread of the new
+        // period at its next call. Returns 0 on success, -1 otherwise.
+        int set_sampling_period_us(int64_t period_us);
+
         // Call this function instead of delete to destroy the sampler. Deletion
         // of the sampler may be delayed for seconds.
         void destroy();
@@ -55,9 +73,23 @@ namespace tally::detail {
     protected:
         virtual ~Sampler();
 
+        // Called with _mutex held before changing the sampling period.
+        virtual bool period_changeable() const { return true; }
+
+        // Called with _mutex held after the sampling period was changed.
+        virtual void on_period_changed() {}
+
+        // Wall clock time of the scheduled tick when called by the sampling
+        // thread, the current time otherwise.
+        int64_t tick_time_us() const {
+            return _tick_us != 0 ? _tick_us : turbo::Time::current_microseconds();
+        }
+
         friend class SamplerCollector;
 
         bool _used;
+        std::atomic<int64_t> _period_us;
+        int64_t _tick_us;
         // Sync destroy() and take_sample().
         std::mutex _mutex;
     };
@@ -82,10 +114,19 @@ namespace tally::detail {
     template<typename R, typename T, typename Op, typename InvOp>
     class ReducerSampler : public Sampler {
     public:
+        // Windows cover at most this many seconds.
         static const time_t MAX_SECONDS_LIMIT = 3600;
+        // Windows of distinct sizes read from a non-invertible reducer are
+        // reduced incrementally, up to this many sizes.
+        static const size_t MAX_SLIDING_WINDOWS = 8;
+        // A window keeps its own copy of each sample in it, so only small
+        // samples are reduced incrementally, e.g. not PercentileSamples
+        // which are reduced from _q on each read.
+        static constexpr bool SLIDING_WINDOWS =
+                std::is_trivially_copyable<T>::value && sizeof(T) <= 64;
 
         explicit ReducerSampler(R *reducer)
-                : _reducer(reducer), _window_size(1) {
+                : _reducer(reducer), _window_size(1), _window_set(false) {
 
             // Invoked take_sample at begining so the value of the first second
             // would not be ignored
@@ -131,8 +172,12 @@ namespace tally::detail {
                 // get_value() of _reducer can still be called.
                 latest.data = _reducer->get_value();
             }
-            latest.time_us = turbo::Time::current_microseconds();
+            latest.time_us = tick_time_us();
             _q.elim_push(latest);
+            for (auto &w: _windows) {
+                w->window.push(latest.data);
+                shrink_window(w.get());
+            }
         }
 
         bool get_value(time_t window_size, Sample<T> *result) {
@@ -145,21 +190,24 @@ namespace tally::detail {
                 // We need more samples to get reasonable result.
                 return false;
             }
-            Sample<T> *oldest = _q.bottom(window_size);
-            if (NULL == oldest) {
-                oldest = _q.top();
-            }
+            Sample<T> *oldest = _q.bottom(samples_in_window(window_size));
             Sample<T> *latest = _q.bottom();
             DKCHECK(latest != oldest);
             if (std::is_same<InvOp, VoidOp>::value) {
-                // No inverse op. Sum up all samples within the window.
-                result->data = latest->data;
-                for (int i = 1; true; ++i) {
-                    Sample<T> *e = _q.bottom(i);
-                    if (e == oldest) {
-                        break;
+                // No inverse op. Sum up all samples within the window, which
+                // is maintained at each sample if possible.
+                Window *w = get_or_create_window(window_size);
+                if (w != nullptr) {
+                    w->window.get(&result->data);
+                } else {
+                    result->data = latest->data;
+                    for (int i = 1; true; ++i) {
+                        Sample<T> *e = _q.bottom(i);
+                        if (e == oldest) {
+                            break;
+                        }
+                        _reducer->op()(result->data, e->data);
                     }
-                    _reducer->op()(result->data, e->data);
                 }
             } else {
                 // Diff the latest and oldest sample within the window.
@@ -170,19 +218,35 @@ namespace tally::detail {
             return true;
         }
 
-        // Change the time window which can only go larger.
+        // Stamp of the latest sample, which changes every tick. 0 if there
+        // is no sample.
+        int64_t latest_time_us() {
+            std::unique_lock lk(_mutex);
+            Sample<T> *latest = _q.bottom();
+            return latest ? latest->time_us : 0;
+        }
+
+        // Change the time window which can only go larger. `window_size' is
+        // in samples, which are seconds unless the sampling period changed.
+        // The sampling period is fixed since.
         int set_window_size(time_t window_size) {
-            if (window_size <= 0 || window_size > MAX_SECONDS_LIMIT) {
+            if (window_size <= 0 || window_size > max_window_size()) {
                 KLOG(ERROR) << "Invalid window_size=" << window_size;
                 return -1;
             }
             std::unique_lock lk(_mutex);
+            _window_set = true;
             if (window_size > _window_size) {
                 _window_size = window_size;
             }
             return 0;
         }
 
+        // Samples within MAX_SECONDS_LIMIT at the current sampling period.
+        time_t max_window_size() const {
+            return MAX_SECONDS_LIMIT * (DEFAULT_PERIOD_US / sampling_period_us());
+        }
+
         void get_samples(std::vector<T> *samples, time_t window_size) {
             if (window_size <= 0) {
                 KLOG(FATAL) << "Invalid window_size=" << window_size;
@@ -193,10 +257,7 @@ namespace tally::detail {
                 // We need more samples to get reasonable result.
                 return;
             }
-            Sample<T> *oldest = _q.bottom(window_size);
-            if (NULL == oldest) {
-                oldest = _q.top();
-            }
+            Sample<T> *oldest = _q.bottom(samples_in_window(window_size));
             for (int i = 1; true; ++i) {
                 Sample<T> *e = _q.bottom(i);
                 if (e == oldest) {
@@ -206,10 +267,143 @@ namespace tally::detail {
             }
         }
 
+        // Samples within the recent `window_size' samples, the latest first,
+        // and the time they span. Only for non-invertible reducers, whose
+        // samples hold what was reduced within their own periods. Returns
+        // false if there's no full period sampled yet.
+        bool get_span_samples(time_t window_size, std::vector<T> *samples, int64_t *span_us) {
+            samples->clear();
+            if (window_size <= 0) {
+                KLOG(FATAL) << "Invalid window_size=" << window_size;
+                return false;
+            }
+            std::unique_lock lk(_mutex);
+            if (_q.size() <= 1) {
+                return false;
+            }
+            const size_t n = samples_in_window(window_size);
+            samples->reserve(n);
+            for (size_t i = 0; i < n; ++i) {
+                samples->push_back(_q.bottom(i)->data);
+            }
+            *span_us = _q.bottom()->time_us - _q.bottom(n)->time_us;
+            return true;
+        }
+
+    protected:
+        bool period_changeable() const override {
+            return !_window_set;
+        }
+
+        // Samples of different periods can't be reduced together, start over.
+        void on_period_changed() override {
+            Sample<T> tmp;
+            while (_q.pop(&tmp)) {
+            }
+            _windows.clear();
+            take_sample();
+        }
+
+    private:
+        struct Window {
+            Window(time_t size, const Op &op) : window_size(size), window(op) {}
+
+            time_t window_size;
+            SlidingWindow<T, Op> window;
+        };
+
+        // Number of the latest samples in a window of `window_size' periods,
+        // which are reduced, or diffed with the one before. Samples stamped
+        // before the window are left out in case of missed ticks, but at
+        // least one is in. Called with at least 2 samples in _q.
+        size_t samples_in_window(time_t window_size) {
+            size_t n = std::min<size_t>(window_size, _q.size() - 1);
+            const int64_t begin_us = _q.bottom()->time_us - window_size * sampling_period_us();
+            while (n > 1 && _q.bottom(n - 1)->time_us <= begin_us) {
+                --n;
+            }
+            return n;
+        }
+
+        void shrink_window(Window *w) {
+            if (_q.size() <= 1) {
+                return;
+            }
+            const size_t n = samples_in_window(w->window_size);
+            while (w->window.size() > n) {
+                w->window.pop();
+            }
+        }
+
+        // Called with _mutex held and at least 2 samples in _q.
+        Window *get_or_create_window(time_t window_size) {
+            for (auto &w: _windows) {
+                if (w->window_size == window_size) {
+                    return w.get();
+                }
+            }
+            if (!SLIDING_WINDOWS || _windows.size() >= MAX_SLIDING_WINDOWS) {
+                return nullptr;
+            }
+            auto w = std::make_unique<Window>(window_size, _reducer->op());
+            for (size_t i = samples_in_window(window_size); i > 0; --i) {
+                w->window.push(_q.bottom(i - 1)->data);
+            }
+            _windows.push_back(std::move(w));
+            return _windows.back().get();
+        }
+
     private:
         R *_reducer;
         time_t _window_size;
+        // Once a window is set, the sampling period can't be changed.
+        bool _window_set;
         turbo::BoundedQueue <Sample<T>> _q;
+        std::vector<std::unique_ptr<Window>> _windows;
+    };
+
+    // The sampler of variables over the recent `window_size' seconds which
+    // keep what each second took, e.g. WindowedHistogram. The ticks
+    // are kept in a ring, the one taken every second replaces the oldest.
+    // take_tick() and on_ticked() are called by the sampling thread, and
+    // readers pass their functions to read(), all with _mutex held.
+    template<typename Tick>
+    class TickRingSampler : public Sampler {
+    public:
+        TickRingSampler(size_t window_size, const Tick &init)
+                : _ticks(window_size, init), _next(0) {}
+
+        void take_sample() final {
+            take_tick(&_ticks[_next]);
+            _next = (_next + 1) % _ticks.size();
+            on_ticked();
+        }
+
+        template<typename F>
+        auto read(const F &f) {
+            std::unique_lock lk(_mutex);
+            return f();
+        }
+
+    protected:
+        // Overwrite `oldest' with what the latest second took.
+        virtual void take_tick(Tick *oldest) = 0;
+
+        // Derive the window once the latest tick is in.
+        virtual void on_ticked() {}
+
+        // The ring is sized in ticks of one second.
+        bool period_changeable() const override { return false; }
+
+        size_t window_size() const { return _ticks.size(); }
+
+        // In no particular order.
+        const std::vector<Tick> &ticks() const { return _ticks; }
+
+    private:
+        std::vector<Tick> _ticks;
+        // The oldest tick.
+        size_t _next;
     };
 
 }  // namespace tally::detail
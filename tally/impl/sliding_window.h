@@ -0,0 +1,92 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+namespace tally::detail {
+
+    // Reduces values in a FIFO window with an associative `Op' which can't
+    // be inversed, e.g. max/min. Values are pushed at the back and popped at
+    // the front. The window is kept as two stacks sharing one deque: the
+    // back stack remembers its values and their reduction, the front stack
+    // remembers reductions of its suffixes. When the front stack runs out,
+    // the back stack is reduced into a front stack in place. Popped values
+    // are released right away, so no more than the window is kept. Pushing
+    // and popping cost amortized O(1) Op, reading costs one Op.
+    template<typename T, typename Op>
+    class SlidingWindow {
+    public:
+        explicit SlidingWindow(const Op &op) : _op(op) {}
+
+        size_t size() const {
+            return _values.size();
+        }
+
+        void push(const T &value) {
+            if (_values.size() == _front_size) {
+                _back_reduced = value;
+            } else {
+                _op(_back_reduced, value);
+            }
+            _values.push_back(value);
+        }
+
+        // Pop the oldest value, the window must not be empty.
+        void pop() {
+            if (_front_size == 0) {
+                flip();
+            }
+            _values.pop_front();
+            --_front_size;
+        }
+
+        // Reduction of all values in the window. Returns false if the
+        // window is empty.
+        bool get(T *result) {
+            if (_front_size > 0) {
+                *result = _values.front();
+                if (_values.size() > _front_size) {
+                    _op(*result, _back_reduced);
+                }
+                return true;
+            }
+            if (!_values.empty()) {
+                *result = _back_reduced;
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        void flip() {
+            // _values[i] reduces _values[i], _values[i + 1] ... _values[n - 1].
+            for (size_t i = _values.size(); i-- > 1;) {
+                _op(_values[i - 1], _values[i]);
+            }
+            _front_size = _values.size();
+        }
+
+    private:
+        Op _op;
+        // The front stack, oldest first, then the back stack.
+        std::deque<T> _values;
+        size_t _front_size{0};
+        T _back_reduced{};
+    };
+
+}  // namespace tally::detail
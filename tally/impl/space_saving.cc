@@ -0,0 +1,102 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/impl/space_saving.h>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+namespace tally::detail {
+
+    void SpaceSaving::add(const std::string &key, int64_t weight) {
+        _total += weight;
+        auto it = _counts.find(key);
+        if (it != _counts.end()) {
+            it->second.count += weight;
+            return;
+        }
+        _counts.emplace(key, Counts{_floor + weight, _floor});
+        if (_counts.size() > 2 * _capacity) {
+            purge();
+        }
+    }
+
+    void SpaceSaving::merge(const SpaceSaving &rhs) {
+        if (_capacity < rhs._capacity) {
+            _capacity = rhs._capacity;
+        }
+        // A key missing from one side counts the floor of that side.
+        for (auto &[key, c]: _counts) {
+            auto it = rhs._counts.find(key);
+            if (it != rhs._counts.end()) {
+                c.count += it->second.count;
+                c.error += it->second.error;
+            } else {
+                c.count += rhs._floor;
+                c.error += rhs._floor;
+            }
+        }
+        for (auto &[key, c]: rhs._counts) {
+            if (_counts.find(key) == _counts.end()) {
+                _counts.emplace(key, Counts{_floor + c.count, _floor + c.error});
+            }
+        }
+        _floor += rhs._floor;
+        _total += rhs._total;
+        if (_counts.size() > 2 * _capacity) {
+            purge();
+        }
+    }
+
+    void SpaceSaving::purge() {
+        std::vector<int64_t> counts;
+        counts.reserve(_counts.size());
+        for (auto &kv: _counts) {
+            counts.push_back(kv.second.count);
+        }
+        // Keys no heavier than the (capacity + 1)-th heaviest one are dropped,
+        // ties included.
+        auto nth = counts.begin() + static_cast<std::ptrdiff_t>(_capacity);
+        std::nth_element(counts.begin(), nth, counts.end(), std::greater<int64_t>());
+        const int64_t threshold = *nth;
+        for (auto it = _counts.begin(); it != _counts.end();) {
+            if (it->second.count <= threshold) {
+                it = _counts.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        _floor = std::max(_floor, threshold);
+    }
+
+    std::vector<TopKEntry> SpaceSaving::top(size_t k) const {
+        std::vector<TopKEntry> entries;
+        entries.reserve(_counts.size());
+        for (auto &[key, c]: _counts) {
+            entries.push_back({key, c.count, c.error});
+        }
+        auto by_count = [](const TopKEntry &a, const TopKEntry &b) {
+            return a.count != b.count ? a.count > b.count : a.key < b.key;
+        };
+        if (entries.size() > k) {
+            std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(k), entries.end(), by_count);
+            entries.resize(k);
+        } else {
+            std::sort(entries.begin(), entries.end(), by_count);
+        }
+        return entries;
+    }
+
+}  // namespace tally::detail
@@ -0,0 +1,95 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tally {
+
+    // A heavy hitter: `count' overestimates the true count of `key' by at
+    // most `error'.
+    struct TopKEntry {
+        std::string key;
+        int64_t count;
+        int64_t error;
+    };
+
+    namespace detail {
+
+        // Space-Saving summary of weighted keys which tracks up to
+        // 2 * capacity keys. A key not tracked has a true count of at most
+        // `floor', so a new key starts from it as count and error. When
+        // more than 2 * capacity keys are tracked, the summary keeps the
+        // `capacity' heaviest and raises `floor' to the largest count
+        // dropped. Adding costs O(1) amortized: a purge is O(capacity)
+        // every `capacity' new keys.
+        // Summaries are mergeable, see merge().
+        class SpaceSaving {
+        public:
+            explicit SpaceSaving(size_t capacity = 0) : _capacity(capacity), _floor(0), _total(0) {}
+
+            void add(const std::string &key, int64_t weight);
+
+            // Summary of the union of both streams.
+            void merge(const SpaceSaving &rhs);
+
+            // The `k' heaviest keys, heaviest first.
+            std::vector<TopKEntry> top(size_t k) const;
+
+            size_t capacity() const { return _capacity; }
+
+            size_t size() const { return _counts.size(); }
+
+            // Sum of all weights added.
+            int64_t total() const { return _total; }
+
+            void clear() {
+                _counts.clear();
+                _floor = 0;
+                _total = 0;
+            }
+
+        private:
+            struct Counts {
+                int64_t count;
+                int64_t error;
+            };
+
+            void purge();
+
+            size_t _capacity;
+            int64_t _floor;
+            int64_t _total;
+            std::unordered_map<std::string, Counts> _counts;
+        };
+
+        struct SpaceSavingMerge {
+            void operator()(SpaceSaving &lhs, const SpaceSaving &rhs) const {
+                lhs.merge(rhs);
+            }
+        };
+
+        struct SpaceSavingAdd {
+            void operator()(SpaceSaving &lhs, const std::pair<const std::string *, int64_t> &value) const {
+                lhs.add(*value.first, value.second);
+            }
+        };
+
+    }  // namespace detail
+}  // namespace tally
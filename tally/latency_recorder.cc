@@ -13,6 +13,7 @@
 // limitations under the License.
 //
 
+#include <algorithm>
 #include <memory>
 #include <tally/latency_recorder.h>
 #include <tally/config.h>
@@ -22,35 +23,17 @@ namespace tally {
 
     namespace detail {
 
-        typedef PercentileSamples<1022> CombinedPercentileSamples;
-
-        /// Cumulative Distribution Function
-        CDF::CDF(PercentileWindow *w) : Variable(VariableAttr::cdf_attr()), _w(w) {}
-
-        CDF::~CDF() {
-            hide();
-        }
-
-        void CDF::describe(std::ostream &os, bool) const {
-            if (_w == nullptr) {
-                return;
-            }
-            std::unique_ptr<CombinedPercentileSamples> cb(new CombinedPercentileSamples);
-            std::vector<GlobalPercentileSamples> buckets;
-            _w->get_samples(&buckets);
-            for (size_t i = 0; i < buckets.size(); ++i) {
-                cb->combine_of(buckets.begin(), buckets.end());
-            }
-            std::pair<int, int> values[20];
+        void describe_cdf(std::ostream &os, CombinedPercentileSamples &cb) {
+            std::pair<int, int64_t> values[20];
             size_t n = 0;
             for (int i = 1; i < 10; ++i) {
-                values[n++] = std::make_pair(i * 10, cb->get_number(i * 0.1));
+                values[n++] = std::make_pair(i * 10, cb.get_number(i * 0.1));
             }
             for (int i = 91; i < 100; ++i) {
-                values[n++] = std::make_pair(i, cb->get_number(i * 0.01));
+                values[n++] = std::make_pair(i, cb.get_number(i * 0.01));
             }
-            values[n++] = std::make_pair(100, cb->get_number(0.999));
-            values[n++] = std::make_pair(101, cb->get_number(0.9999));
+            values[n++] = std::make_pair(100, cb.get_number(0.999));
+            values[n++] = std::make_pair(101, cb.get_number(0.9999));
             KCHECK_EQ(n, TURBO_ARRAYSIZE(values));
             os << "{\"label\":\"cdf\",\"data\":[";
             for (size_t i = 0; i < n; ++i) {
@@ -62,8 +45,59 @@ namespace tally {
             os << "]}";
         }
 
-        // Return random int value with expectation = `dval'
-        static int64_t double_to_random_int(double dval) {
+        /// Cumulative Distribution Function
+        CDF::CDF(LatencyRecorderBase *owner) : Variable(VariableAttr::cdf_attr()), _owner(owner) {}
+
+        CDF::~CDF() {
+            hide();
+        }
+
+        void CDF::describe(std::ostream &os, bool) const {
+            if (_owner == nullptr) {
+                return;
+            }
+            describe_cdf(os, *_owner->combined_percentile_samples());
+        }
+
+        turbo::Status normalize_quantiles(std::vector<double> *quantiles) {
+            for (auto q: *quantiles) {
+                if (!(q > 0 && q <= 1)) {
+                    return turbo::invalid_argument_error("Invalid quantile=%f", q);
+                }
+            }
+            std::sort(quantiles->begin(), quantiles->end());
+            quantiles->erase(std::unique(quantiles->begin(), quantiles->end()), quantiles->end());
+            return turbo::OkStatus();
+        }
+
+        LatencySummary::LatencySummary(LatencyRecorderBase *owner)
+                : Variable(VariableAttr::summary_attr()), _owner(owner) {}
+
+        LatencySummary::~LatencySummary() {
+            hide();
+        }
+
+        void describe_summary(std::ostream &os, const SummarySample &s) {
+            os << '{';
+            for (auto &q: s.quantiles) {
+                os << q.first << '=' << q.second << ' ';
+            }
+            os << "sum=" << s.sample_sum << " count=" << s.sample_count << '}';
+        }
+
+        void LatencySummary::describe(std::ostream &os, bool) const {
+            describe_summary(os, _owner->summary());
+        }
+
+        void LatencySummary::get_value(std::any *value) const {
+            *value = _owner->summary();
+        }
+
+        MetricSample LatencySummary::get_metric(const turbo::Time &stamp) const {
+            return MetricSample{VariableType::summary_type(), _owner->summary(), stamp};
+        }
+
+        int64_t double_to_random_int(double dval) {
             int64_t ival = static_cast<int64_t>(dval);
             if (dval > ival + turbo::fast_rand_double()) {
                 ival += 1;
@@ -74,37 +108,13 @@ namespace tally {
 
         turbo::Status CDF::describe_series(
                 std::ostream& os, const SeriesOptions& options) const {
-            if (_w == nullptr) {
+            if (_owner == nullptr) {
                 return turbo::unavailable_error("");
             }
             if (options.test_only) {
                 return turbo::OkStatus();
             }
-            std::unique_ptr<CombinedPercentileSamples> cb(new CombinedPercentileSamples);
-            std::vector<GlobalPercentileSamples> buckets;
-            _w->get_samples(&buckets);
-            for (size_t i = 0; i < buckets.size(); ++i) {
-                cb->combine_of(buckets.begin(), buckets.end());
-            }
-            std::pair<int, int> values[20];
-            size_t n = 0;
-            for (int i = 1; i < 10; ++i) {
-                values[n++] = std::make_pair(i*10, cb->get_number(i * 0.1));
-            }
-            for (int i = 91; i < 100; ++i) {
-                values[n++] = std::make_pair(i, cb->get_number(i * 0.01));
-            }
-            values[n++] = std::make_pair(100, cb->get_number(0.999));
-            values[n++] = std::make_pair(101, cb->get_number(0.9999));
-            KCHECK_EQ(n, TURBO_ARRAYSIZE(values));
-            os << "{\"label\":\"cdf\",\"data\":[";
-            for (size_t i = 0; i < n; ++i) {
-                if (i) {
-                    os << ',';
-                }
-                os << '[' << values[i].first << ',' << values[i].second << ']';
-            }
-            os << "]}";
+            describe_cdf(os, *_owner->combined_percentile_samples());
             return turbo::OkStatus();
         }
 
@@ -123,32 +133,21 @@ namespace tally {
             return static_cast<AverageGauge *>(arg)->get_value().num;
         }
 
-        // Caller is responsible for deleting the return value.
-        static CombinedPercentileSamples *combine(PercentileWindow *w) {
-            CombinedPercentileSamples *cb = new CombinedPercentileSamples;
-            std::vector<GlobalPercentileSamples> buckets;
-            w->get_samples(&buckets);
-            cb->combine_of(buckets.begin(), buckets.end());
-            return cb;
-        }
-
         template<int64_t numerator, int64_t denominator>
         static int64_t get_percetile(LatencyRecorderBase *arg) {
             return arg->latency_percentile(
                     (double) numerator / double(denominator));
         }
 
-        static Vector<int64_t, 4> get_latencies(void *arg) {
-            std::unique_ptr<CombinedPercentileSamples> cb(
-                    combine((PercentileWindow *) arg));
+        static Vector<int64_t, 4> get_latencies(const LatencyRecorderBase *rec) {
             // NOTE: We don't show 99.99% since it's often significantly larger than
             // other values and make other curves on the plotted graph small and
             // hard to read.
             Vector<int64_t, 4> result;
-            result[0] = cb->get_number(turbo::get_flag(FLAGS_tally_latency_p1) / 100.0);
-            result[1] = cb->get_number(turbo::get_flag(FLAGS_tally_latency_p2) / 100.0);
-            result[2] = cb->get_number(turbo::get_flag(FLAGS_tally_latency_p3) / 100.0);
-            result[3] = cb->get_number(0.999);
+            result[0] = rec->latency_percentile(turbo::get_flag(FLAGS_tally_latency_p1) / 100.0);
+            result[1] = rec->latency_percentile(turbo::get_flag(FLAGS_tally_latency_p2) / 100.0);
+            result[2] = rec->latency_percentile(turbo::get_flag(FLAGS_tally_latency_p3) / 100.0);
+            result[3] = rec->latency_percentile(0.999);
             return result;
         }
 
@@ -179,33 +178,81 @@ namespace tally {
                     return get_percetile<999, 1000>(this);
                 }),
                   _latency_9999([this]() { return get_percetile<9999, 10000>(this); }),
-                  _latency_cdf(&_latency_percentile_window),
+                  _latency_cdf(this),
                   _latency_percentiles([this]() {
-                      std::unique_ptr<CombinedPercentileSamples> cb(
-                              combine(&this->_latency_percentile_window));
-                      // NOTE: We don't show 99.99% since it's often significantly larger than
-                      // other values and make other curves on the plotted graph small and
-                      // hard to read.
-                      Vector<int64_t, 4> result;
-                      result[0] = cb->get_number(turbo::get_flag(FLAGS_tally_latency_p1) / 100.0);
-                      result[1] = cb->get_number(turbo::get_flag(FLAGS_tally_latency_p2) / 100.0);
-                      result[2] = cb->get_number(turbo::get_flag(FLAGS_tally_latency_p3) / 100.0);
-                      result[3] = cb->get_number(0.999);
-                      return result;
-                  }) {}
+                      return get_latencies(this);
+                  }),
+                  _latency_summary(this) {}
 
         int64_t LatencyRecorderBase::latency_percentile(double ratio) const {
-            std::unique_ptr<detail::CombinedPercentileSamples> cb(
-                    combine((detail::PercentileWindow *) &_latency_percentile_window));
-            return cb->get_number(ratio);
+            const int64_t time_us = _latency_percentile_window.latest_sample_time_us();
+            std::unique_lock lk(_combined_mutex);
+            if (time_us != _percentiles_time_us) {
+                // Combine once for all the percentiles exported by the
+                // recorder, which are read one by one in a scrape.
+                auto cb = combine_percentile_samples(time_us);
+                _percentiles.clear();
+                for (auto r: {turbo::get_flag(FLAGS_tally_latency_p1) / 100.0,
+                              turbo::get_flag(FLAGS_tally_latency_p2) / 100.0,
+                              turbo::get_flag(FLAGS_tally_latency_p3) / 100.0, 0.999, 0.9999}) {
+                    _percentiles.emplace_back(r, cb->get_number(r));
+                }
+                for (auto q: _quantiles) {
+                    _percentiles.emplace_back(q, cb->get_number(q));
+                }
+                _percentiles_time_us = time_us;
+            }
+            for (auto &p: _percentiles) {
+                if (p.first == ratio) {
+                    return p.second;
+                }
+            }
+            const int64_t value = combine_percentile_samples(time_us)->get_number(ratio);
+            if (_percentiles.size() < MAX_CACHED_PERCENTILES) {
+                _percentiles.emplace_back(ratio, value);
+            }
+            return value;
+        }
+
+        SummarySample LatencyRecorderBase::summary() const {
+            SummarySample s;
+            s.quantiles.reserve(_quantiles.size());
+            for (auto q: _quantiles) {
+                s.quantiles.emplace_back(q, latency_percentile(q));
+            }
+            const Stat stat = _latency.get_value();
+            s.sample_sum = static_cast<double>(stat.sum);
+            s.sample_count = stat.num;
+            return s;
+        }
+
+        std::shared_ptr<CombinedPercentileSamples> LatencyRecorderBase::combined_percentile_samples() const {
+            const int64_t time_us = _latency_percentile_window.latest_sample_time_us();
+            // Readers of the same tick wait for the one combining.
+            std::unique_lock lk(_combined_mutex);
+            return combine_percentile_samples(time_us);
+        }
+
+        std::shared_ptr<CombinedPercentileSamples> LatencyRecorderBase::combine_percentile_samples(
+                int64_t time_us) const {
+            auto cb = _combined.lock();
+            if (cb && time_us == _combined_time_us) {
+                return cb;
+            }
+            cb = std::make_shared<CombinedPercentileSamples>();
+            std::vector<GlobalPercentileSamples> buckets;
+            _latency_percentile_window.get_samples(&buckets);
+            cb->combine_of(buckets.begin(), buckets.end());
+            cb->sort();
+            _combined = cb;
+            _combined_time_us = time_us;
+            return cb;
         }
 
     }  // namespace detail
 
     Vector<int64_t, 4> LatencyRecorder::latency_percentiles() const {
-        // const_cast here is just to adapt parameter type and safe.
-        return detail::get_latencies(
-                const_cast<detail::PercentileWindow *>(&_latency_percentile_window));
+        return detail::get_latencies(this);
     }
 
     int64_t LatencyRecorder::qps(time_t window_size) const {
@@ -251,30 +298,38 @@ namespace tally {
             return rs;
         }
 
-        auto p1 = turbo::str_format("%s_latency_%d", prefix.c_str(), (int) turbo::get_flag(FLAGS_tally_latency_p1));
-        rs = _latency_p1.expose(p1, help, scope);
-        if (!rs.ok()) {
-            return rs;
-        }
-        auto p2 = turbo::str_format("%s_latency_%d", prefix.c_str(), (int) turbo::get_flag(FLAGS_tally_latency_p2));
-        rs = _latency_p2.expose(p2, help, scope);
-        if (!rs.ok()) {
-            return rs;
-        }
-        auto p3 = turbo::str_format("%s_latency_%d", prefix.c_str(), (int) turbo::get_flag(FLAGS_tally_latency_p3));
-        rs = _latency_p3.expose(p3, help, scope);
-        if (!rs.ok()) {
-            return rs;
-        }
+        if (!_quantiles.empty()) {
+            // One summary in place of the gauges.
+            rs = _latency_summary.expose(prefix + "_latency_summary", help, scope);
+            if (!rs.ok()) {
+                return rs;
+            }
+        } else {
+            auto p1 = turbo::str_format("%s_latency_%d", prefix.c_str(), (int) turbo::get_flag(FLAGS_tally_latency_p1));
+            rs = _latency_p1.expose(p1, help, scope);
+            if (!rs.ok()) {
+                return rs;
+            }
+            auto p2 = turbo::str_format("%s_latency_%d", prefix.c_str(), (int) turbo::get_flag(FLAGS_tally_latency_p2));
+            rs = _latency_p2.expose(p2, help, scope);
+            if (!rs.ok()) {
+                return rs;
+            }
+            auto p3 = turbo::str_format("%s_latency_%d", prefix.c_str(), (int) turbo::get_flag(FLAGS_tally_latency_p3));
+            rs = _latency_p3.expose(p3, help, scope);
+            if (!rs.ok()) {
+                return rs;
+            }
 
-        rs = _latency_999.expose(prefix + "_latency_999", help, scope);
-        if (!rs.ok()) {
-            return rs;
-        }
+            rs = _latency_999.expose(prefix + "_latency_999", help, scope);
+            if (!rs.ok()) {
+                return rs;
+            }
 
-        rs = _latency_9999.expose(prefix + "_latency_9999", help, scope);
-        if (!rs.ok()) {
-            return rs;
+            rs = _latency_9999.expose(prefix + "_latency_9999", help, scope);
+            if (!rs.ok()) {
+                return rs;
+            }
         }
         rs = _latency_percentiles.expose(prefix + "_latency_percentiles", help, scope);
         if (!rs.ok()) {
@@ -305,6 +360,20 @@ namespace tally {
         _latency_9999.hide();
         _latency_cdf.hide();
         _latency_percentiles.hide();
+        _latency_summary.hide();
+    }
+
+    turbo::Status LatencyRecorder::set_quantiles(std::vector<double> quantiles) {
+        if (!_latency_window.name().empty()) {
+            return turbo::failed_precondition_error("set quantiles of exposed LatencyRecorder %s",
+                                                    _latency_window.name());
+        }
+        auto rs = detail::normalize_quantiles(&quantiles);
+        if (!rs.ok()) {
+            return rs;
+        }
+        _quantiles = std::move(quantiles);
+        return turbo::OkStatus();
     }
 
     LatencyRecorder &LatencyRecorder::operator<<(int64_t latency) {
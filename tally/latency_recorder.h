@@ -17,6 +17,10 @@
 #include <tally/gauge.h>
 #include <tally/impl/reducer.h>
 #include <tally/impl/percentile.h>
+#include <tally/time_unit.h>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace tally {
     namespace detail {
@@ -27,18 +31,51 @@ namespace tally {
         typedef Window<MaxerGauge<int64_t>, SERIES_IN_SECOND> MaxWindow;
         typedef Window<Percentile, SERIES_IN_SECOND> PercentileWindow;
 
+        typedef PercentileSamples<1022> CombinedPercentileSamples;
+
+        // Write percentiles of `cb' as the json plotted for a CDF.
+        void describe_cdf(std::ostream &os, CombinedPercentileSamples &cb);
+
+        void describe_summary(std::ostream &os, const SummarySample &s);
+
+        // Return random int value with expectation = `dval'
+        int64_t double_to_random_int(double dval);
+
+        // Sort and dedup `quantiles', which must be within (0, 1].
+        turbo::Status normalize_quantiles(std::vector<double> *quantiles);
+
+        class LatencyRecorderBase;
+
         // NOTE: Always use int64_t in the interfaces no matter what the impl. is.
 
         class CDF : public Variable {
         public:
-            explicit CDF(PercentileWindow *w);
+            explicit CDF(LatencyRecorderBase *owner);
 
             ~CDF();
 
             void describe(std::ostream &os, bool quote_string) const override;
             turbo::Status describe_series(std::ostream& os, const SeriesOptions& options) const override;
         private:
-            PercentileWindow *_w;
+            LatencyRecorderBase *_owner;
+        };
+
+        // Quantiles of the recent window with sum and count of all latencies
+        // ever recorded, exported as a prometheus summary.
+        class LatencySummary : public Variable {
+        public:
+            explicit LatencySummary(LatencyRecorderBase *owner);
+
+            ~LatencySummary();
+
+            void describe(std::ostream &os, bool quote_string) const override;
+
+            void get_value(std::any *value) const override;
+
+            MetricSample get_metric(const turbo::Time &stamp) const override;
+
+        private:
+            LatencyRecorderBase *_owner;
         };
 
         // For mimic constructor inheritance.
@@ -52,7 +89,29 @@ namespace tally {
             // E.g. 0.99 means 99%-ile
             int64_t latency_percentile(double ratio) const;
 
+            // Samples of the percentile window combined and sorted. Readers
+            // of the same sampling tick share one combination while any of
+            // them holds it. Don't modify.
+            std::shared_ptr<CombinedPercentileSamples> combined_percentile_samples() const;
+
+            // Quantiles exported by the summary, empty if not set.
+            const std::vector<double> &quantiles() const { return _quantiles; }
+
+            // Unit of durations passed to record(), microseconds by default.
+            TimeUnit time_unit() const { return _time_unit; }
+
+            void set_time_unit(TimeUnit unit) { _time_unit = unit; }
+
+            // Quantiles of the window, with sum and count of all latencies.
+            SummarySample summary() const;
+
         protected:
+            // At most so many percentiles are kept per sampling tick.
+            static constexpr size_t MAX_CACHED_PERCENTILES = 16;
+
+            // Called with _combined_mutex held.
+            std::shared_ptr<CombinedPercentileSamples> combine_percentile_samples(int64_t time_us) const;
+
             AverageGauge _latency;
             MaxerGauge<int64_t> _max_latency;
             Percentile _latency_percentile;
@@ -69,6 +128,17 @@ namespace tally {
             FuncGauge<int64_t> _latency_9999; // 99.99%
             CDF _latency_cdf;
             PassiveStatus<Vector<int64_t, 4> > _latency_percentiles;
+            std::vector<double> _quantiles;
+            LatencySummary _latency_summary;
+            TimeUnit _time_unit{TimeUnit::kMicroseconds};
+
+            mutable std::mutex _combined_mutex;
+            // Not kept after the readers, samples of a window are kilobytes.
+            mutable std::weak_ptr<CombinedPercentileSamples> _combined;
+            mutable int64_t _combined_time_us{0};
+            // Percentiles of the latest tick, combined from the samples once.
+            mutable std::vector<std::pair<double, int64_t>> _percentiles;
+            mutable int64_t _percentiles_time_us{0};
         };
     } // namespace detail
 
@@ -100,11 +170,29 @@ namespace tally {
             }
         }
 
+        // Export `quantiles' as a summary instead of the percentile gauges,
+        // see set_quantiles().
+        LatencyRecorder(const std::string_view &prefix, std::string_view help, Scope *scope,
+                        time_t window_size, std::vector<double> quantiles) : Base(window_size) {
+            auto rs = set_quantiles(std::move(quantiles));
+            if (rs.ok()) {
+                rs = expose(prefix, help, scope);
+            }
+            if (!rs.ok()) {
+                KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                                << "expose LatencyRecorder failed: " << prefix << "to scope" << scope->id();
+                KLOG(WARNING) << "expose LatencyRecorder failed: " << prefix << "to scope" << scope->id();
+            }
+        }
+
         ~LatencyRecorder() { hide(); }
 
         // Record the latency.
         LatencyRecorder &operator<<(int64_t latency);
 
+        // Record `d' in time_unit().
+        LatencyRecorder &record(turbo::Duration d) { return *this << to_time_unit(d, time_unit()); }
+
         // Expose all internal variables using `prefix' as prefix.
         // Returns 0 on success, -1 otherwise.
         // Example:
@@ -123,6 +211,13 @@ namespace tally {
         // Hide all internal variables, called in dtor as well.
         void hide();
 
+        // Quantiles to export, each within (0, 1], e.g. {0.5, 0.99}. Once
+        // set, expose() exports them along with sum and count as a summary
+        // named `<prefix>_latency_summary', computed once per sampling tick,
+        // instead of the gauges of p1/p2/p3/99.9/99.99-ile latencies.
+        // Must be called before expose().
+        turbo::Status set_quantiles(std::vector<double> quantiles);
+
         // Get the average latency in recent |window_size| seconds
         // If |window_size| is absent, use the window_size to ctor.
         int64_t latency(time_t window_size) const { return _latency_window.get_value(window_size).get_average_int(); }
@@ -157,6 +252,8 @@ namespace tally {
         const std::string &count_name() const { return _count.name(); }
 
         const std::string &qps_name() const { return _qps.name(); }
+
+        const std::string &latency_summary_name() const { return _latency_summary.name(); }
     };
 
     std::ostream &operator<<(std::ostream &os, const LatencyRecorder &);
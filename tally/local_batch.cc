@@ -0,0 +1,46 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/local_batch.h>
+
+namespace tally {
+
+    LocalBatch::HistogramSlot::HistogramSlot(Histogram *histogram)
+            : _histogram(histogram), _counts(histogram->buckets_value_.size(), 0), _count(0), _sum(0) {}
+
+    void LocalBatch::HistogramSlot::flush() {
+        if (_count == 0) {
+            return;
+        }
+        DKCHECK(_counts.size() == _histogram->buckets_value_.size());
+        for (size_t i = 0; i < _counts.size() && i < _histogram->buckets_value_.size(); ++i) {
+            if (_counts[i] != 0) {
+                _histogram->buckets_value_[i] << _counts[i];
+                _counts[i] = 0;
+            }
+        }
+        _histogram->sample_count_ << _count;
+        _histogram->sample_sum_ << _sum;
+        _count = 0;
+        _sum = 0;
+    }
+
+    LocalBatch::HistogramSlot &LocalBatch::get(Histogram *histogram) {
+        auto *slot = new HistogramSlot(histogram);
+        _slots.emplace_back(slot);
+        return *slot;
+    }
+
+}  // namespace tally
@@ -0,0 +1,155 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <tally/impl/reducer.h>
+#include <tally/histogram.h>
+
+namespace tally {
+
+    // Updates of reducers and histograms staged in plain members and applied
+    // in one modification per metric when the batch is flushed or destroyed.
+    // For inner loops updating a handful of metrics millions of times.
+    // Example:
+    //   tally::LocalBatch batch;
+    //   auto &rows = batch.get(&g_rows);          // Counter<int64_t>
+    //   auto &latency = batch.get(&g_latency);    // Histogram
+    //   for (...) {
+    //       rows << 1;
+    //       latency.record(x);
+    //   }
+    //   // Applied here.
+    //
+    // Staged updates are invisible until flushed. A flush applies each
+    // metric atomically, but not the metrics of a batch together, nor the
+    // buckets, sum and count of a histogram, as if the staged updates were
+    // made at the time of flush() one metric after another.
+    // A batch must be used and destroyed by one thread. It must not outlive
+    // the metrics it updates.
+    class LocalBatch {
+    public:
+        // Staged updates of a Reducer.
+        template<typename T, typename Op, typename InvOp, typename Agents>
+        class ReducerSlot;
+
+        // Staged updates of a Histogram.
+        class HistogramSlot;
+
+        LocalBatch() = default;
+
+        ~LocalBatch() { flush(); }
+
+        LocalBatch(const LocalBatch &) = delete;
+
+        LocalBatch &operator=(const LocalBatch &) = delete;
+
+        // Stage updates of `reducer' in the returned slot, which is valid
+        // until the batch is destroyed.
+        template<typename T, typename Op, typename InvOp, typename Agents>
+        ReducerSlot<T, Op, InvOp, Agents> &get(Reducer<T, Op, InvOp, Agents> *reducer);
+
+        HistogramSlot &get(Histogram *histogram);
+
+        // Apply all staged updates.
+        void flush() {
+            for (auto &slot: _slots) {
+                slot->flush();
+            }
+        }
+
+    private:
+        class Slot {
+        public:
+            virtual ~Slot() = default;
+
+            virtual void flush() = 0;
+        };
+
+        std::vector<std::unique_ptr<Slot>> _slots;
+    };
+
+    template<typename T, typename Op, typename InvOp, typename Agents>
+    class LocalBatch::ReducerSlot : public LocalBatch::Slot {
+    public:
+        typedef Reducer<T, Op, InvOp, Agents> reducer_type;
+
+        explicit ReducerSlot(reducer_type *reducer)
+                : _combiner(&reducer->_combiner), _value(_combiner->element_identity()), _dirty(false) {}
+
+        ReducerSlot &operator<<(typename add_cr_non_integral<T>::type value) {
+            call_op_returning_void(_combiner->op(), _value, value);
+            _dirty = true;
+            return *this;
+        }
+
+        void flush() override {
+            if (!_dirty) {
+                return;
+            }
+            auto *agent = _combiner->get_or_create_tls_agent();
+            if (TURBO_UNLIKELY(!agent)) {
+                KLOG(FATAL) << "Fail to create agent";
+                return;
+            }
+            agent->element.modify(_combiner->op(), _value);
+            _value = _combiner->element_identity();
+            _dirty = false;
+        }
+
+    private:
+        typename reducer_type::combiner_type *_combiner;
+        T _value;
+        bool _dirty;
+    };
+
+    class LocalBatch::HistogramSlot : public LocalBatch::Slot {
+    public:
+        explicit HistogramSlot(Histogram *histogram);
+
+        // Buckets of a Histogram are set at most once, possibly after the
+        // slot was made, but not while it's recorded concurrently.
+        void record(double value) {
+            if (TURBO_UNLIKELY(_counts.size() != _histogram->buckets_value_.size())) {
+                // Nothing was staged without buckets.
+                _counts.assign(_histogram->buckets_value_.size(), 0);
+                if (_counts.empty()) {
+                    return;
+                }
+            }
+            ++_counts[_histogram->bucket_index(value)];
+            ++_count;
+            _sum += value;
+        }
+
+        void flush() override;
+
+    private:
+        Histogram *_histogram;
+        std::vector<int64_t> _counts;
+        int64_t _count;
+        double _sum;
+    };
+
+    template<typename T, typename Op, typename InvOp, typename Agents>
+    LocalBatch::ReducerSlot<T, Op, InvOp, Agents> &LocalBatch::get(Reducer<T, Op, InvOp, Agents> *reducer) {
+        auto *slot = new ReducerSlot<T, Op, InvOp, Agents>(reducer);
+        _slots.emplace_back(slot);
+        return *slot;
+    }
+
+}  // namespace tally
@@ -16,8 +16,8 @@
 
 #include <turbo/times/time.h>
 #include <tally/gauge.h>
-#include <turbo/times/time.h>
 #include <tally/latency_recorder.h>
+#include <tally/utility/cycle_timer.h>
 
 // Monitor the time for acquiring a lock.
 // We provide some wrappers of mutex which can also be maintained by 
@@ -31,7 +31,8 @@
 // mutex from all the common scenarios. Saying that you can use them freely 
 // without concerning about the overhead. Except that the mutex is very 
 // frequently acquired (>1M/s) with very little contention, in which case, the
-// overhead of timers and tally is noticable.
+// overhead of timers and tally is noticable. Timers read the TSC when it's
+// invariant, see CycleClock.
 // 
 // There are two kinds of special Mutex:
 //  - MutexWithRecorder: Create a mutex along with a shared IntRecorder which
@@ -206,7 +207,7 @@ namespace tally {
                     *mutex << timer.u_elapsed();
                 }
 
-                turbo::TimeCost timer;
+                CycleTimer timer;
                 Mutex *mutex;
             };
 
@@ -320,7 +321,7 @@ namespace tally {
 
         private:
             // Don't change the order or timer and _lck;
-            turbo::TimeCost _timer;
+            CycleTimer _timer;
             std::unique_lock<typename Mutex::mutex_type> _lock;
             mutex_type *_mutex;
         };
@@ -0,0 +1,136 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/meter.h>
+#include <tally/config.h>
+#include <cmath>
+
+namespace tally {
+
+    // Moves the averages every sampling period. Every member is guarded by
+    // _mutex, which is held by the sampling thread when calling
+    // take_sample().
+    class Meter::MeterSampler : public detail::Sampler {
+    public:
+        MeterSampler(const Counter<int64_t> *count, const std::vector<time_t> &horizons)
+                : _count(count), _horizons(horizons), _rates(horizons.size(), 0),
+                  _last_count(count->get_value()), _last_us(turbo::Time::current_microseconds()),
+                  _started(false) {}
+
+        void take_sample() override {
+            const int64_t now_us = tick_time_us();
+            const int64_t count = _count->get_value();
+            if (now_us <= _last_us) {
+                return;
+            }
+            const double seconds = static_cast<double>(now_us - _last_us) / 1000000.0;
+            const double instant = static_cast<double>(count - _last_count) / seconds;
+            _last_count = count;
+            _last_us = now_us;
+            for (size_t i = 0; i < _horizons.size(); ++i) {
+                if (!_started) {
+                    // Start from the first rate rather than climbing from 0.
+                    _rates[i] = instant;
+                    continue;
+                }
+                const double alpha = 1.0 - std::exp(-seconds / static_cast<double>(_horizons[i]));
+                _rates[i] += alpha * (instant - _rates[i]);
+            }
+            _started = true;
+        }
+
+        double get_rate(size_t index) {
+            std::unique_lock lk(_mutex);
+            return _rates[index];
+        }
+
+        std::vector<double> get_rates() {
+            std::unique_lock lk(_mutex);
+            return _rates;
+        }
+
+    private:
+        const Counter<int64_t> *_count;
+        const std::vector<time_t> _horizons;
+        std::vector<double> _rates;
+        int64_t _last_count;
+        int64_t _last_us;
+        bool _started;
+    };
+
+    Meter::Meter(const std::vector<time_t> &horizons) noexcept
+            : Variable(VariableAttr::gauge_attr()), horizons_(horizons) {
+        for (auto &h: horizons_) {
+            h = std::max<time_t>(h, 1);
+            if (h % 60 == 0) {
+                windows_.push_back(std::to_string(h / 60) + "m");
+            } else {
+                windows_.push_back(std::to_string(h) + "s");
+            }
+        }
+        sampler_ = new MeterSampler(&count_, horizons_);
+        sampler_->schedule();
+    }
+
+    Meter::Meter(std::string_view name, std::string_view help, turbo::Nonnull<Scope *> scope,
+                 const std::vector<time_t> &horizons) noexcept
+            : Meter(horizons) {
+        auto rs = expose(name, help, scope);
+        if (!rs.ok()) {
+            KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                            << "expose Meter failed: " << name << "to scope" << scope->id();
+            KLOG(WARNING) << "expose Meter failed: " << name << "to scope" << scope->id();
+        }
+    }
+
+    Meter::~Meter() {
+        hide();
+        sampler_->destroy();
+        sampler_ = nullptr;
+    }
+
+    double Meter::rate(size_t index) const {
+        return sampler_->get_rate(index);
+    }
+
+    std::vector<double> Meter::rates() const {
+        return sampler_->get_rates();
+    }
+
+    void Meter::describe(std::ostream &os, bool) const {
+        auto values = rates();
+        os << '{';
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i) {
+                os << ' ';
+            }
+            os << windows_[i] << '=' << values[i];
+        }
+        os << '}';
+    }
+
+    MetricSample Meter::get_metric(const turbo::Time &stamp) const {
+        return {type(), horizons_.empty() ? 0.0 : rate(0), stamp};
+    }
+
+    MetricSample Meter::get_child_metric(size_t index, const turbo::Time &stamp) const {
+        return {type(), rate(index), stamp};
+    }
+
+    void Meter::child_labels(size_t index, turbo::flat_hash_map<std::string, std::string> *labels) const {
+        (*labels)[std::string("window")] = windows_[index];
+    }
+
+}  // namespace tally
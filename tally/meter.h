@@ -0,0 +1,94 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <tally/counter.h>
+#include <tally/impl/sampler.h>
+
+namespace tally {
+
+    // Rates of events per second as exponentially weighted moving averages,
+    // e.g. the 1, 5 and 15 minute load averages of uptime. Events go to a
+    // Counter. Every sampling period a sampler takes the rate since the
+    // last period and moves each average towards it by
+    //   1 - exp(-period / horizon)
+    // so a meter takes O(1) memory whatever its horizons are, while
+    // PerSecond<> keeps a sample per second of its window.
+    //
+    // The meter is exported as one gauge family with a sample per horizon,
+    // labelled by `window', e.g.
+    //   rpc_rate{window="1m"} 12.5
+    //   rpc_rate{window="5m"} 11.9
+    //   rpc_rate{window="15m"} 10.2
+    class Meter : public Variable {
+    public:
+        // Horizons in seconds, 1, 5 and 15 minutes by default. Non-positive
+        // ones are taken as one second.
+        explicit Meter(const std::vector<time_t> &horizons = {60, 300, 900}) noexcept;
+
+        Meter(std::string_view name, std::string_view help,
+              turbo::Nonnull<Scope *> scope = ScopeInstance::instance()->get_default().get(),
+              const std::vector<time_t> &horizons = {60, 300, 900}) noexcept;
+
+        ~Meter() override;
+
+        Meter(const Meter &) = delete;
+        Meter &operator=(const Meter &) = delete;
+
+        void mark(int64_t n = 1) { count_ << n; }
+
+        Meter &operator<<(int64_t n) {
+            count_ << n;
+            return *this;
+        }
+
+        // Events marked so far.
+        int64_t count() const { return count_.get_value(); }
+
+        const std::vector<time_t> &horizons() const { return horizons_; }
+
+        // Events per second averaged over horizons()[index]. 0 until the
+        // first sampling period ends.
+        double rate(size_t index) const;
+
+        std::vector<double> rates() const;
+
+        void describe(std::ostream &os, bool quote_string) const override;
+
+        void get_value(std::any *value) const override { *value = rates(); }
+
+        // The rate of horizons()[0].
+        MetricSample get_metric(const turbo::Time &stamp) const override;
+
+        bool has_children() const override { return true; }
+
+        size_t num_children() const override { return horizons_.size(); }
+
+        MetricSample get_child_metric(size_t index, const turbo::Time &stamp) const override;
+
+        void child_labels(size_t index, turbo::flat_hash_map<std::string, std::string> *labels) const override;
+
+    private:
+        class MeterSampler;
+
+        Counter<int64_t> count_;
+        std::vector<time_t> horizons_;
+        // Values of the `window' label, e.g. "1m" or "90s".
+        std::vector<std::string> windows_;
+        MeterSampler *sampler_;
+    };
+
+}  // namespace tally
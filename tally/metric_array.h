@@ -0,0 +1,343 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <array>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tally/counter.h>
+#include <tally/gauge.h>
+#include <tally/histogram.h>
+
+namespace tally {
+
+    namespace detail {
+
+        // Values of all children of a MetricArray, the element of one
+        // thread. Copied bytewise, see ElementContainer.
+        template<typename T, size_t N>
+        struct MetricCells {
+            T values[N];
+        };
+
+        // How a MetricArray reduces values of `Child'.
+        template<typename Child>
+        struct MetricArrayTraits;
+
+        template<typename T>
+        struct MetricArrayTraits<Counter<T> > {
+            typedef T value_type;
+            typedef AddTo<T> Op;
+
+            static constexpr VariableAttr attr() { return VariableAttr::counter_attr(); }
+
+            static T identity() { return T(); }
+        };
+
+        template<typename T>
+        struct MetricArrayTraits<MaxerGauge<T> > {
+            typedef T value_type;
+            typedef MaxTo<T> Op;
+
+            static constexpr VariableAttr attr() { return VariableAttr::gauge_attr(); }
+
+            static T identity() { return std::numeric_limits<T>::min(); }
+        };
+
+        template<typename T>
+        struct MetricArrayTraits<MinerGauge<T> > {
+            typedef T value_type;
+            typedef MinTo<T> Op;
+
+            static constexpr VariableAttr attr() { return VariableAttr::gauge_attr(); }
+
+            static T identity() { return std::numeric_limits<T>::max(); }
+        };
+
+        template<typename T>
+        struct MetricArrayTraits<UpDownGauge<T> > {
+            typedef T value_type;
+            typedef AddTo<T> Op;
+
+            static constexpr VariableAttr attr() { return VariableAttr::gauge_attr(); }
+
+            static T identity() { return T(); }
+        };
+
+    }  // namespace detail
+
+    // N counters or gauges labelled by values of one label with a small
+    // fixed domain, e.g. HTTP status class or shard id. Children are indexed
+    // by an enum or integer less than N rather than looked up by tags, a
+    // thread keeps values of all children in one agent, and the array is
+    // exported as one family.
+    // Example:
+    //   enum class StatusClass { k2xx, k4xx, k5xx };
+    //   constexpr std::string_view kStatusClasses[] = {"2xx", "4xx", "5xx"};
+    //   tally::MetricArray<tally::Counter<int64_t>, 3> g_responses(
+    //           "http_responses", "responses by status class", "class", kStatusClasses);
+    //   g_responses[StatusClass::k4xx] << 1;
+    //   # http_responses{class="4xx"} 1
+    // Supported children are Counter, MaxerGauge, MinerGauge and UpDownGauge.
+    template<typename Child, size_t N>
+    class MetricArray : public Variable {
+    public:
+        typedef detail::MetricArrayTraits<Child> traits_type;
+        typedef typename traits_type::value_type value_type;
+        typedef detail::MetricCells<value_type, N> cells_type;
+
+        // Apply the op of children to one cell.
+        struct ModifyCell {
+            void operator()(cells_type &cells, const std::pair<size_t, value_type> &v) const {
+                typename traits_type::Op()(cells.values[v.first], v.second);
+            }
+        };
+
+        // Apply the op of children to each pair of cells.
+        struct MergeCells {
+            void operator()(cells_type &lhs, const cells_type &rhs) const {
+                for (size_t i = 0; i < N; ++i) {
+                    typename traits_type::Op()(lhs.values[i], rhs.values[i]);
+                }
+            }
+        };
+
+        typedef detail::AgentCombiner<cells_type, cells_type, MergeCells> combiner_type;
+
+        // Updates one child.
+        class Ref {
+        public:
+            Ref(MetricArray *array, size_t index) : _array(array), _index(index) {}
+
+            Ref &operator<<(value_type value) {
+                _array->modify(_index, value);
+                return *this;
+            }
+
+            value_type get_value() const { return _array->get_value(_index); }
+
+        private:
+            MetricArray *_array;
+            size_t _index;
+        };
+
+        MetricArray(std::string_view label_name, const std::string_view (&label_values)[N])
+                : Variable(traits_type::attr()), _combiner(identity_cells(), identity_cells()),
+                  _label_name(label_name) {
+            for (size_t i = 0; i < N; ++i) {
+                _label_values[i] = label_values[i];
+            }
+        }
+
+        MetricArray(std::string_view name, std::string_view help, std::string_view label_name,
+                    const std::string_view (&label_values)[N],
+                    turbo::Nonnull<Scope *> scope = ScopeInstance::instance()->get_default().get())
+                : MetricArray(label_name, label_values) {
+            auto rs = this->expose(name, help, scope);
+            if (!rs.ok()) {
+                KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                                << "expose MetricArray failed: " << name << "to scope" << scope->id();
+                KLOG(WARNING) << "expose MetricArray failed: " << name << "to scope" << scope->id();
+            }
+        }
+
+        ~MetricArray() override { hide(); }
+
+        template<typename Index>
+        Ref operator[](Index index) {
+            DKCHECK_LT(static_cast<size_t>(index), N);
+            return Ref(this, static_cast<size_t>(index));
+        }
+
+        template<typename Index>
+        value_type get_value(Index index) const {
+            DKCHECK_LT(static_cast<size_t>(index), N);
+            return _combiner.combine_agents().values[static_cast<size_t>(index)];
+        }
+
+        // Values of all children.
+        std::array<value_type, N> get_values() const {
+            const cells_type cells = _combiner.combine_agents();
+            std::array<value_type, N> values;
+            for (size_t i = 0; i < N; ++i) {
+                values[i] = cells.values[i];
+            }
+            return values;
+        }
+
+        void get_value(std::any *value) const override {
+            *value = get_values();
+        }
+
+        void describe(std::ostream &os, bool) const override {
+            const cells_type cells = _combiner.combine_agents();
+            os << '{';
+            for (size_t i = 0; i < N; ++i) {
+                if (i) {
+                    os << ' ';
+                }
+                os << _label_values[i] << '=' << cells.values[i];
+            }
+            os << '}';
+        }
+
+        // All children reduced into one.
+        MetricSample get_metric(const turbo::Time &stamp) const override {
+            const cells_type cells = _combiner.combine_agents();
+            value_type v = traits_type::identity();
+            for (size_t i = 0; i < N; ++i) {
+                typename traits_type::Op()(v, cells.values[i]);
+            }
+            return {type(), static_cast<double>(v), stamp};
+        }
+
+        bool has_children() const override { return true; }
+
+        size_t num_children() const override { return N; }
+
+        MetricSample get_child_metric(size_t index, const turbo::Time &stamp) const override {
+            return {type(), static_cast<double>(get_value(index)), stamp};
+        }
+
+        void child_labels(size_t index, turbo::flat_hash_map<std::string, std::string> *labels) const override {
+            (*labels)[_label_name] = _label_values[index];
+        }
+
+        // All children from one combination of the agents.
+        void children(const turbo::Time &stamp, std::vector<VariableChild> *children) const override {
+            const cells_type cells = _combiner.combine_agents();
+            children->resize(N);
+            for (size_t i = 0; i < N; ++i) {
+                auto &child = (*children)[i];
+                child.labels.clear();
+                child_labels(i, &child.labels);
+                child.sample = {type(), static_cast<double>(cells.values[i]), stamp};
+            }
+        }
+
+    private:
+        void modify(size_t index, value_type value) {
+            DKCHECK_LT(index, N);
+            auto *agent = _combiner.get_or_create_tls_agent();
+            if (TURBO_UNLIKELY(!agent)) {
+                KLOG(FATAL) << "Fail to create agent";
+                return;
+            }
+            agent->element.modify(ModifyCell(), std::make_pair(index, value));
+        }
+
+        static cells_type identity_cells() {
+            cells_type cells;
+            for (size_t i = 0; i < N; ++i) {
+                cells.values[i] = traits_type::identity();
+            }
+            return cells;
+        }
+
+        combiner_type _combiner;
+        const std::string _label_name;
+        std::array<std::string, N> _label_values;
+    };
+
+    // N histograms of the same buckets labelled by values of one label, see
+    // MetricArray. Children are Histograms indexed by an enum or integer
+    // less than N, and the array is exported as one histogram family.
+    template<size_t N>
+    class HistogramArray : public Variable {
+    public:
+        HistogramArray(const Buckets &buckets, std::string_view label_name,
+                       const std::string_view (&label_values)[N])
+                : Variable(VariableAttr::histogram_attr()), _label_name(label_name) {
+            for (size_t i = 0; i < N; ++i) {
+                _children[i].set_buckets(buckets);
+                _label_values[i] = label_values[i];
+            }
+        }
+
+        HistogramArray(const Buckets &buckets, std::string_view name, std::string_view help,
+                       std::string_view label_name, const std::string_view (&label_values)[N],
+                       turbo::Nonnull<Scope *> scope = ScopeInstance::instance()->get_default().get())
+                : HistogramArray(buckets, label_name, label_values) {
+            auto rs = this->expose(name, help, scope);
+            if (!rs.ok()) {
+                KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                                << "expose HistogramArray failed: " << name << "to scope" << scope->id();
+                KLOG(WARNING) << "expose HistogramArray failed: " << name << "to scope" << scope->id();
+            }
+        }
+
+        ~HistogramArray() override { hide(); }
+
+        template<typename Index>
+        Histogram &operator[](Index index) {
+            DKCHECK_LT(static_cast<size_t>(index), N);
+            return _children[static_cast<size_t>(index)];
+        }
+
+        template<typename Index>
+        const Histogram &operator[](Index index) const {
+            DKCHECK_LT(static_cast<size_t>(index), N);
+            return _children[static_cast<size_t>(index)];
+        }
+
+        void describe(std::ostream &os, bool) const override {
+            os << '{';
+            for (size_t i = 0; i < N; ++i) {
+                if (i) {
+                    os << ' ';
+                }
+                os << _label_values[i] << '=' << _children[i].sample_count();
+            }
+            os << '}';
+        }
+
+        // All children merged into one.
+        MetricSample get_metric(const turbo::Time &stamp) const override {
+            HistogramSample merged{_children[0].get_value(), 0, 0, {}};
+            for (auto &b: merged.buckets) {
+                b.value = 0;
+            }
+            for (size_t i = 0; i < N; ++i) {
+                auto buckets = _children[i].get_value();
+                for (size_t j = 0; j < buckets.size() && j < merged.buckets.size(); ++j) {
+                    merged.buckets[j].value += buckets[j].value;
+                }
+                merged.sample_sum += _children[i].sample_sum();
+                merged.sample_count += _children[i].sample_count();
+            }
+            return {type(), std::move(merged), stamp};
+        }
+
+        bool has_children() const override { return true; }
+
+        size_t num_children() const override { return N; }
+
+        MetricSample get_child_metric(size_t index, const turbo::Time &stamp) const override {
+            return _children[index].get_metric(stamp);
+        }
+
+        void child_labels(size_t index, turbo::flat_hash_map<std::string, std::string> *labels) const override {
+            (*labels)[_label_name] = _label_values[index];
+        }
+
+    private:
+        Histogram _children[N];
+        const std::string _label_name;
+        std::array<std::string, N> _label_values;
+    };
+
+}  // namespace tally
@@ -15,14 +15,198 @@
 
 
 #include <tally/reportor.h>
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <sstream>
+#include <thread>
 #include <tally/config.h>
 #include <tally/scope.h>
 #include <tally/reporters/prometheus_stats_reporter.h>
+#include <tally/reporters/protobuf_stats_reporter.h>
+#include <turbo/strings/str_split.h>
 
 namespace tally {
 
+    namespace {
+        std::string_view trim_space(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+                s.remove_prefix(1);
+            }
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+                s.remove_suffix(1);
+            }
+            return s;
+        }
+
+        std::string cache_key(ExpositionFormat format, const ReportOptions *options) {
+            std::string key(1, static_cast<char>('0' + static_cast<int>(format)));
+            if (options) {
+                key.push_back(options->quote_string() ? 'q' : '-');
+                key.push_back(options->question_mark());
+                key.append(options->white_wildcards());
+                key.push_back('\0');
+                key.append(options->black_wildcards());
+            }
+            return key;
+        }
+
+        size_t report_parallelism(const ReportOptions *options) {
+            int32_t n = options ? options->parallelism() : 0;
+            if (n <= 0) {
+                n = turbo::get_flag(FLAGS_tally_report_parallelism);
+            }
+            if (n <= 0) {
+                n = static_cast<int32_t>(std::thread::hardware_concurrency());
+            }
+            return std::clamp<size_t>(n, 1, Variable::registry_shard_count());
+        }
+
+        // Threads rendering registry shards for render(), started on demand
+        // and kept for later scrapes. Like the sampling threads, they are
+        // started again in a forked child.
+        class RenderWorkers {
+        public:
+            static RenderWorkers *instance() {
+                static std::once_flag once;
+                std::call_once(once, [] {
+                    s_instance.store(new RenderWorkers, std::memory_order_release);
+                    pthread_atfork(nullptr, nullptr, after_forked_as_child);
+                });
+                return s_instance.load(std::memory_order_acquire);
+            }
+
+            // Run `task' on one of at least `threads' workers.
+            void run(std::function<void()> task, size_t threads) {
+                std::unique_lock lk(_mutex);
+                for (; _threads < threads; ++_threads) {
+                    std::thread(&RenderWorkers::work, this).detach();
+                }
+                _tasks.push_back(std::move(task));
+                _cond.notify_one();
+            }
+
+        private:
+            // The workers of the parent are gone in the child, along with
+            // whatever they held.
+            static void after_forked_as_child() {
+                s_instance.store(new RenderWorkers, std::memory_order_release);
+            }
+
+            void work() {
+                std::unique_lock lk(_mutex);
+                while (true) {
+                    _cond.wait(lk, [this] { return !_tasks.empty(); });
+                    auto task = std::move(_tasks.front());
+                    _tasks.pop_front();
+                    lk.unlock();
+                    task();
+                    lk.lock();
+                }
+            }
+
+            static std::atomic<RenderWorkers *> s_instance;
+
+            std::mutex _mutex;
+            std::condition_variable _cond;
+            std::deque<std::function<void()>> _tasks;
+            size_t _threads{0};
+        };
+
+        std::atomic<RenderWorkers *> RenderWorkers::s_instance{nullptr};
+
+        // Shards of one render() in flight, guarded by `mutex'.
+        struct ShardRendering {
+            std::mutex mutex;
+            std::condition_variable cond;
+            std::vector<std::string> buffers;
+            std::vector<bool> rendered;
+            // The next shard to render.
+            size_t next{0};
+            // Shards written out.
+            size_t written{0};
+            // Workers not done yet.
+            size_t running{0};
+        };
+
+        // Render with reporters made by `make', which writes to the given
+        // ostream. With parallelism, workers render the registry shards one
+        // by one into their own buffers, and this thread writes each buffer
+        // to `os' once the shards before it are written, so the output is
+        // the same as rendered by one thread. Workers run at most
+        // 2 * parallelism shards ahead of the writing, which bounds the
+        // buffered output to so many shards. The trailer, if any, is written
+        // by a last reporter without variables.
+        template<typename MakeReporter>
+        void render(std::ostream &os, const MakeReporter &make, ReportOptions *options) {
+            const auto stamp = turbo::Time::current_time();
+            const size_t parallelism = report_parallelism(options);
+            if (parallelism == 1) {
+                auto reporter = make(os);
+                if (options) {
+                    reporter->set_option(*options);
+                }
+                Variable::report(reporter.get(), stamp);
+                reporter->flush();
+                return;
+            }
+            const size_t shards = Variable::registry_shard_count();
+            const size_t window = 2 * parallelism;
+            ShardRendering r;
+            r.buffers.resize(shards);
+            r.rendered.assign(shards, false);
+            r.running = parallelism;
+            auto work = [&r, &make, &stamp, options, shards, window] {
+                std::unique_lock lk(r.mutex);
+                while (true) {
+                    r.cond.wait(lk, [&] { return r.next == shards || r.next < r.written + window; });
+                    if (r.next == shards) {
+                        break;
+                    }
+                    const size_t shard = r.next++;
+                    lk.unlock();
+                    std::ostringstream out;
+                    auto reporter = make(out);
+                    if (options) {
+                        reporter->set_option(*options);
+                    }
+                    Variable::report(reporter.get(), stamp, shard, shard + 1);
+                    std::string buffer = out.str();
+                    lk.lock();
+                    r.buffers[shard] = std::move(buffer);
+                    r.rendered[shard] = true;
+                    r.cond.notify_all();
+                }
+                --r.running;
+                r.cond.notify_all();
+            };
+            for (size_t i = 0; i < parallelism; ++i) {
+                RenderWorkers::instance()->run(work, parallelism);
+            }
+            std::unique_lock lk(r.mutex);
+            for (size_t shard = 0; shard < shards; ++shard) {
+                r.cond.wait(lk, [&] { return r.rendered[shard]; });
+                std::string buffer = std::move(r.buffers[shard]);
+                lk.unlock();
+                os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                lk.lock();
+                ++r.written;
+                r.cond.notify_all();
+            }
+            // `work' refers to `r' until every worker is done.
+            r.cond.wait(lk, [&] { return r.running == 0; });
+            lk.unlock();
+            make(os)->flush();
+        }
+    }  // namespace
+
     turbo::Status Reporter::register_reporter(const std::shared_ptr<StatsReporter> &r) {
         if (r->name().empty()) {
             return turbo::data_loss_error("StatsReporter need set name before schedule");
@@ -115,11 +299,220 @@ namespace tally {
     }
 
     void Reporter::get_prometheus_reporting(std::ostream &os, ReportOptions *options) {
-        PrometheusStatsReporter reporter(os);
-        if(options) {
-            reporter.set_option(*options);
+        render(os, [](std::ostream &out) {
+            return std::make_unique<PrometheusStatsReporter>(out);
+        }, options);
+    }
+
+    std::string Reporter::get_openmetrics_reporting(ReportOptions *options) {
+        std::stringstream ss;
+        get_openmetrics_reporting(ss, options);
+        return ss.str();
+    }
+
+    void Reporter::get_openmetrics_reporting(std::ostream &os, ReportOptions *options) {
+        render(os, [](std::ostream &out) {
+            return std::make_unique<PrometheusStatsReporter>(out, true);
+        }, options);
+    }
+
+    std::string Reporter::get_protobuf_reporting(ReportOptions *options) {
+        std::stringstream ss;
+        get_protobuf_reporting(ss, options);
+        return ss.str();
+    }
+
+    void Reporter::get_protobuf_reporting(std::ostream &os, ReportOptions *options) {
+        render(os, [](std::ostream &out) {
+            return std::make_unique<ProtobufStatsReporter>(out);
+        }, options);
+    }
+
+    ExpositionFormat Reporter::negotiate_format(std::string_view accept) {
+        ExpositionFormat best = ExpositionFormat::kPrometheusText;
+        double best_q = 0;
+        for (auto range: turbo::str_split(accept, ',')) {
+            std::vector<std::string_view> params = turbo::str_split(range, ';');
+            if (params.empty()) {
+                continue;
+            }
+            auto media = trim_space(params[0]);
+            double q = 1.0;
+            std::string_view proto;
+            std::string_view encoding;
+            for (size_t i = 1; i < params.size(); ++i) {
+                auto param = trim_space(params[i]);
+                auto eq = param.find('=');
+                if (eq == std::string_view::npos) {
+                    continue;
+                }
+                auto key = trim_space(param.substr(0, eq));
+                auto value = trim_space(param.substr(eq + 1));
+                if (key == "q") {
+                    q = std::strtod(std::string(value).c_str(), nullptr);
+                } else if (key == "proto") {
+                    proto = value;
+                } else if (key == "encoding") {
+                    encoding = value;
+                }
+            }
+            ExpositionFormat format;
+            if (media == "application/vnd.google.protobuf") {
+                if (proto != "io.prometheus.client.MetricFamily" || encoding != "delimited") {
+                    continue;
+                }
+                format = ExpositionFormat::kProtobufDelimited;
+            } else if (media == "application/openmetrics-text") {
+                format = ExpositionFormat::kOpenMetricsText;
+            } else if (media == "text/plain" || media == "text/*" || media == "*/*") {
+                format = ExpositionFormat::kPrometheusText;
+            } else {
+                continue;
+            }
+            // the first one wins on equal quality.
+            if (q > best_q) {
+                best_q = q;
+                best = format;
+            }
+        }
+        return best;
+    }
+
+    std::string_view Reporter::content_type(ExpositionFormat format) {
+        switch (format) {
+            case ExpositionFormat::kOpenMetricsText:
+                return PrometheusStatsReporter::kOpenMetricsContentType;
+            case ExpositionFormat::kProtobufDelimited:
+                return ProtobufStatsReporter::kContentType;
+            case ExpositionFormat::kPrometheusText:
+            default:
+                return PrometheusStatsReporter::kContentType;
+        }
+    }
+
+    std::string Reporter::get_reporting(ExpositionFormat format, ReportOptions *options) {
+        std::stringstream ss;
+        get_reporting(ss, format, options);
+        return ss.str();
+    }
+
+    void Reporter::get_reporting(std::ostream &os, ExpositionFormat format, ReportOptions *options) {
+        switch (format) {
+            case ExpositionFormat::kOpenMetricsText:
+                get_openmetrics_reporting(os, options);
+                break;
+            case ExpositionFormat::kProtobufDelimited:
+                get_protobuf_reporting(os, options);
+                break;
+            case ExpositionFormat::kPrometheusText:
+            default:
+                get_prometheus_reporting(os, options);
+                break;
+        }
+    }
+
+    bool Reporter::stream_reporting(const ChunkSink &sink, ExpositionFormat format,
+                                    ReportOptions *options, size_t chunk_size) {
+        // Parallel rendering buffers shards ahead of the writing.
+        ReportOptions serial = options ? *options : ReportOptions();
+        serial.parallelism(1);
+        ChunkStreamBuf buf(sink, chunk_size);
+        std::ostream os(&buf);
+        get_reporting(os, format, &serial);
+        buf.pubsync();
+        return buf.ok();
+    }
+
+    std::shared_ptr<const std::string> Reporter::get_cached_reporting(
+            ExpositionFormat format, ReportOptions *options) {
+        return get_cached_reporting(format, options, turbo::get_flag(FLAGS_tally_scrape_cache_max_age_ms));
+    }
+
+    std::shared_ptr<const std::string> Reporter::get_cached_reporting(
+            ExpositionFormat format, ReportOptions *options, int64_t max_age_ms) {
+        auto &ins = instance();
+        std::call_once(ins._cache_expose_once, [&ins] {
+            auto scope = ScopeInstance::instance()->get_sys_scope().get();
+            auto rs = ins._cache_hit.expose("scrape_cache_hit", "scrapes served from the cached reporting", scope);
+            if (!rs.ok()) {
+                KLOG(WARNING) << "expose scrape_cache_hit fail reason: " << rs.to_string();
+            }
+            rs = ins._cache_miss.expose("scrape_cache_miss", "scrapes rendered the reporting", scope);
+            if (!rs.ok()) {
+                KLOG(WARNING) << "expose scrape_cache_miss fail reason: " << rs.to_string();
+            }
+        });
+        const auto key = cache_key(format, options);
+        std::unique_lock lk(ins._cache_mutex);
+        auto it = ins._cache.find(key);
+        if (it == ins._cache.end()) {
+            ins.evict_cached_reporting();
+            it = ins._cache.emplace(key, std::make_shared<CachedReporting>()).first;
+        }
+        // The entry outlives rehashing and eviction of `_cache' while unlocked.
+        std::shared_ptr<CachedReporting> entry = it->second;
+        const uint64_t version = entry->version;
+        while (entry->rendering) {
+            ins._cache_cond.wait(lk);
+        }
+        // The output is gone if the cache was cleared meanwhile, render again.
+        if (entry->output && (entry->version != version ||
+            turbo::Time::current_microseconds() - entry->rendered_us <= max_age_ms * 1000)) {
+            // Rendered by the scrape we waited for, or fresh enough.
+            ins._cache_hit << 1;
+            return entry->output;
+        }
+        entry->rendering = true;
+        lk.unlock();
+        ins._cache_miss << 1;
+
+        const int64_t start_us = turbo::Time::current_microseconds();
+        std::shared_ptr<std::string> output;
+        try {
+            output = std::make_shared<std::string>(get_reporting(format, options));
+        } catch (...) {
+            lk.lock();
+            entry->rendering = false;
+            ins._cache_cond.notify_all();
+            throw;
+        }
+        lk.lock();
+        entry->output = output;
+        // Age from the start, values are read since then.
+        entry->rendered_us = start_us;
+        ++entry->version;
+        entry->rendering = false;
+        ins._cache_cond.notify_all();
+        return output;
+    }
+
+    void Reporter::clear_reporting_cache() {
+        auto &ins = instance();
+        std::unique_lock lk(ins._cache_mutex);
+        for (auto &it: ins._cache) {
+            it.second->output.reset();
+        }
+        ins._cache.clear();
+    }
+
+    void Reporter::evict_cached_reporting() {
+        if (_cache.size() < kMaxCachedReportings) {
+            return;
+        }
+        // Drop the stalest idle entry. Entries being rendered are kept for
+        // the scrapes waiting on them.
+        auto victim = _cache.end();
+        for (auto it = _cache.begin(); it != _cache.end(); ++it) {
+            if (it->second->rendering) {
+                continue;
+            }
+            if (victim == _cache.end() || it->second->rendered_us < victim->second->rendered_us) {
+                victim = it;
+            }
+        }
+        if (victim != _cache.end()) {
+            _cache.erase(victim);
         }
-        Variable::report(&reporter,turbo::Time::current_time());
     }
 
     std::string Reporter::get_json_reporting() {
@@ -23,9 +23,8 @@ namespace tally {
         //state = ReportState{};
     }
 
-    void DumpJsonStatsReporter::report_counter(const Variable *v,  const turbo::Time &stamp, nlohmann::ordered_json &out) {
+    void DumpJsonStatsReporter::report_counter(const MetricSample &sample, nlohmann::ordered_json &out) {
         try {
-            MetricSample sample = v->get_metric(stamp);
             auto value = std::get<double>(sample.value);
             out["value"] = value;
         } catch (const std::exception &e) {
@@ -33,9 +32,8 @@ namespace tally {
         }
     }
 
-    void DumpJsonStatsReporter::report_gauge(const Variable *v,  const turbo::Time &stamp, nlohmann::ordered_json &out) {
+    void DumpJsonStatsReporter::report_gauge(const MetricSample &sample, nlohmann::ordered_json &out) {
         try {
-            MetricSample sample = v->get_metric(stamp);
             auto value = std::get<double>(sample.value);
             out["value"] = value;
         } catch (const std::exception &e) {
@@ -43,10 +41,9 @@ namespace tally {
         }
     }
 
-    void DumpJsonStatsReporter::report_histogram(const Variable *v,  const turbo::Time &stamp, nlohmann::ordered_json &out) {
+    void DumpJsonStatsReporter::report_histogram(const MetricSample &sample, nlohmann::ordered_json &out) {
         try {
 
-            MetricSample sample = v->get_metric(stamp);
             auto hist = std::get<HistogramSample>(sample.value);
             nlohmann::ordered_json value;
             value["sum"] = hist.sample_sum;
@@ -76,6 +73,26 @@ namespace tally {
 
     }
 
+    void DumpJsonStatsReporter::report_summary(const MetricSample &sample, nlohmann::ordered_json &out) {
+        try {
+            auto &summary = std::get<SummarySample>(sample.value);
+            nlohmann::ordered_json value;
+            value["sum"] = summary.sample_sum;
+            value["count"] = summary.sample_count;
+            nlohmann::ordered_json value_quantile = nlohmann::ordered_json::array();
+            for (auto &q: summary.quantiles) {
+                nlohmann::ordered_json cell;
+                cell["quantile"] = q.first;
+                cell["value"] = q.second;
+                value_quantile.push_back(std::move(cell));
+            }
+            value["quantile"] = std::move(value_quantile);
+            out["value"] = std::move(value);
+        } catch (const std::exception &e) {
+            KLOG(ERROR) << "bad type: " << e.what();
+        }
+    }
+
     void DumpJsonStatsReporter::report_flag(const Variable *v,  const turbo::Time &stamp, nlohmann::ordered_json &out) {
         std::any an_value;
         v->get_value(&an_value);
@@ -93,7 +110,6 @@ namespace tally {
     void DumpJsonStatsReporter::report_variable(
             const Variable *var, const turbo::Time &stamp) {
         ++state.total;
-        nlohmann::ordered_json obj;
         auto &full_name = var->full_name();
         auto &name = var->full_name();
         auto &prefix = var->prefix();
@@ -106,42 +122,64 @@ namespace tally {
             return;
         } else if(t.is_flag()) {
             vtype = "flag";
-            report_flag(var, stamp, obj);
         } else if (t.is_counter()) {
             state.counter_count++;
             vtype = "counter";
-            report_counter(var, stamp, obj);
         } else if (t.is_histogram()) {
             state.hist_count++;
             vtype = "is_histogram";
-            report_histogram(var, stamp, obj);
+        } else if (t.is_summary()) {
+            state.summary_count++;
+            vtype = "summary";
         } else if (t.is_gauge()) {
             state.gauge_count++;
             vtype = "gauge";
-            report_gauge(var, stamp, obj);
         } else {
             vtype = "variable";
             state.no_metric_count++;
-            obj["value"] = var->get_description();
         }
-        obj["name"] = name;
-        obj["full_name"] = full_name;
-        obj["prefix"] = prefix;
-        if (!help.empty()) {
-            obj["help"] = help;
+        // Other variables are dumped as one child without labels.
+        std::vector<VariableChild> children;
+        if (t.is_metric() && !t.is_flag()) {
+            var->children(stamp, &children);
         } else {
-            obj["help"] = "help";
+            children.resize(1);
         }
-        obj["type"] = vtype;
-        obj["timestamp_ms"] = turbo::Time::to_milliseconds(stamp);
-        auto dt = turbo::Time::format(stamp, turbo::get_flag(FLAGS_tally_dump_local) ? turbo::TimeZone::local() : turbo::TimeZone::utc());
-        obj["date"] = dt;
-        nlohmann::ordered_json js_tags;
-        for (auto &it: tags) {
-            js_tags[it.first] = it.second;
+        turbo::flat_hash_map<std::string, std::string> scratch;
+        for (auto &child: children) {
+            nlohmann::ordered_json obj;
+            if (t.is_flag()) {
+                report_flag(var, stamp, obj);
+            } else if (t.is_counter()) {
+                report_counter(child.sample, obj);
+            } else if (t.is_histogram()) {
+                report_histogram(child.sample, obj);
+            } else if (t.is_summary()) {
+                report_summary(child.sample, obj);
+            } else if (t.is_gauge()) {
+                report_gauge(child.sample, obj);
+            } else {
+                obj["value"] = var->get_description();
+            }
+            obj["name"] = name;
+            obj["full_name"] = full_name;
+            obj["prefix"] = prefix;
+            if (!help.empty()) {
+                obj["help"] = help;
+            } else {
+                obj["help"] = "help";
+            }
+            obj["type"] = vtype;
+            obj["timestamp_ms"] = turbo::Time::to_milliseconds(stamp);
+            auto dt = turbo::Time::format(stamp, turbo::get_flag(FLAGS_tally_dump_local) ? turbo::TimeZone::local() : turbo::TimeZone::utc());
+            obj["date"] = dt;
+            nlohmann::ordered_json js_tags;
+            for (auto &it: Variable::child_tags(child, tags, &scratch)) {
+                js_tags[it.first] = it.second;
+            }
+            obj["tags"] = std::move(js_tags);
+            _dumped.push_back(obj.dump());
         }
-        obj["tags"] = std::move(js_tags);
-        _dumped.push_back(obj.dump());
     }
 
 }  // namespace tally
@@ -43,6 +43,7 @@ namespace tally {
             os << "gauge: " << state.gauge_count << "\n";
             os << "counter: " << state.counter_count << "\n";
             os << "histogram: " << state.hist_count << "\n";
+            os << "summary: " << state.summary_count << "\n";
             os << "not metric: " << state.no_metric_count << "\n";
             os << "filter off: " << state.discard_count << "\n";
         }
@@ -53,11 +54,15 @@ namespace tally {
 
         using StatsReporter::describe;
     private:
-        static void report_counter(const Variable *value,  const turbo::Time &stamp, nlohmann::ordered_json &out);
+        // Metric `sample' of one child of the variable, see
+        // Variable::children().
+        static void report_counter(const MetricSample &sample, nlohmann::ordered_json &out);
 
-        static void report_gauge(const Variable *v,  const turbo::Time &stamp, nlohmann::ordered_json &out);
+        static void report_gauge(const MetricSample &sample, nlohmann::ordered_json &out);
 
-        static void report_histogram(const Variable *v,  const turbo::Time &stamp, nlohmann::ordered_json &out);
+        static void report_histogram(const MetricSample &sample, nlohmann::ordered_json &out);
+
+        static void report_summary(const MetricSample &sample, nlohmann::ordered_json &out);
 
         static void report_flag(const Variable *v,  const turbo::Time &stamp, nlohmann::ordered_json &out);
 
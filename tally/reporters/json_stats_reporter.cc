@@ -32,9 +32,8 @@ namespace tally {
     void JsonStatsReporter::report_counter(
             std::string_view name,
             std::string_view help,
-            const turbo::flat_hash_map<std::string, std::string> &tags, const Variable *v,  const turbo::Time &stamp) {
+            const turbo::flat_hash_map<std::string, std::string> &tags, const MetricSample &sample) {
         try {
-            MetricSample sample = v->get_metric(stamp);
             auto value = std::get<double>(sample.value);
             nlohmann::ordered_json obj;
             obj["name"] = name;
@@ -60,9 +59,8 @@ namespace tally {
     void JsonStatsReporter::report_gauge(
             std::string_view name,
             std::string_view help,
-            const turbo::flat_hash_map<std::string, std::string> &tags, const Variable *v,  const turbo::Time &stamp) {
+            const turbo::flat_hash_map<std::string, std::string> &tags, const MetricSample &sample) {
         try {
-            MetricSample sample = v->get_metric(stamp);
             auto value = std::get<double>(sample.value);
             nlohmann::ordered_json obj;
             obj["name"] = name;
@@ -89,10 +87,9 @@ namespace tally {
             std::string_view name,
             std::string_view help,
             const turbo::flat_hash_map<std::string, std::string> &tags,
-            const Variable* v,  const turbo::Time &stamp) {
+            const MetricSample &sample) {
         try {
 
-            MetricSample sample = v->get_metric(stamp);
             auto hist = std::get<HistogramSample>(sample.value);
             nlohmann::ordered_json obj;
             obj["name"] = name;
@@ -137,6 +134,45 @@ namespace tally {
 
     }
 
+    void JsonStatsReporter::report_summary(
+            std::string_view name,
+            std::string_view help,
+            const turbo::flat_hash_map<std::string, std::string> &tags,
+            const MetricSample &sample) {
+        try {
+            auto &summary = std::get<SummarySample>(sample.value);
+            nlohmann::ordered_json obj;
+            obj["name"] = name;
+            if (!help.empty()) {
+                obj["help"] = help;
+            } else {
+                obj["help"] = "help";
+            }
+            obj["type"] = "summary";
+            obj["timestamp_ms"] = turbo::Time::to_milliseconds(sample.timestamp);
+            nlohmann::ordered_json value;
+            value["sum"] = summary.sample_sum;
+            value["count"] = summary.sample_count;
+            nlohmann::ordered_json value_quantile = nlohmann::ordered_json::array();
+            for (auto &q: summary.quantiles) {
+                nlohmann::ordered_json cell;
+                cell["quantile"] = q.first;
+                cell["value"] = q.second;
+                value_quantile.push_back(std::move(cell));
+            }
+            value["quantile"] = std::move(value_quantile);
+            obj["value"] = std::move(value);
+            nlohmann::ordered_json js_tags;
+            for (auto &it: tags) {
+                js_tags[it.first] = it.second;
+            }
+            obj["tags"] = std::move(js_tags);
+            _os_json["metric"].push_back(std::move(obj));
+        } catch (const std::exception &e) {
+            KLOG(ERROR) << "bad type: " << e.what();
+        }
+    }
+
     void JsonStatsReporter::report_flag(
             std::string_view n,
             std::string_view h,
@@ -184,6 +220,8 @@ namespace tally {
         auto &tags = var->tags();
         auto &help = var->help();
         auto t = var->type();
+        turbo::flat_hash_map<std::string, std::string> scratch;
+        std::vector<VariableChild> children;
         if (t.is_empty()) {
             state.discard_count++;
             return;
@@ -191,13 +229,28 @@ namespace tally {
             report_flag(full_name, help, tags, var, stamp);
         } else if (t.is_counter()) {
             state.counter_count++;
-            report_counter(full_name, help, tags, var, stamp);
+            var->children(stamp, &children);
+            for (auto &child: children) {
+                report_counter(full_name, help, Variable::child_tags(child, tags, &scratch), child.sample);
+            }
         } else if (t.is_histogram()) {
             state.hist_count++;
-            report_histogram(full_name, help, tags, var, stamp);
+            var->children(stamp, &children);
+            for (auto &child: children) {
+                report_histogram(full_name, help, Variable::child_tags(child, tags, &scratch), child.sample);
+            }
+        } else if (t.is_summary()) {
+            state.summary_count++;
+            var->children(stamp, &children);
+            for (auto &child: children) {
+                report_summary(full_name, help, Variable::child_tags(child, tags, &scratch), child.sample);
+            }
         } else if (t.is_gauge()) {
             state.gauge_count++;
-            report_gauge(full_name, help, tags, var, stamp);
+            var->children(stamp, &children);
+            for (auto &child: children) {
+                report_gauge(full_name, help, Variable::child_tags(child, tags, &scratch), child.sample);
+            }
         } else {
             nlohmann::ordered_json obj;
             obj["name"] = name;
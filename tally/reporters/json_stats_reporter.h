@@ -44,6 +44,7 @@ namespace tally {
             os<<"gauge: "<<state.gauge_count<<"\n";
             os<<"counter: "<<state.counter_count<<"\n";
             os<<"histogram: "<<state.hist_count<<"\n";
+            os<<"summary: "<<state.summary_count<<"\n";
             os<<"not metric: "<<state.no_metric_count<<"\n";
             os<<"filter off: "<<state.discard_count<<"\n";
         }
@@ -51,21 +52,29 @@ namespace tally {
         using StatsReporter::describe;
     private:
         void init();
+
+        // Metric `sample' of one child, see Variable::children().
         void report_counter(std::string_view name,
                             std::string_view help,
                             const turbo::flat_hash_map<std::string, std::string> &tags,
-                            const Variable* value, const turbo::Time &stamp);
+                            const MetricSample &sample);
 
         void report_gauge(std::string_view name,
                           std::string_view help,
                           const turbo::flat_hash_map<std::string, std::string> &tags,
-                          const Variable* value, const turbo::Time &stamp);
+                          const MetricSample &sample);
 
         void report_histogram(
                 std::string_view name,
                 std::string_view help,
                 const turbo::flat_hash_map<std::string, std::string> &tags,
-                const Variable* value, const turbo::Time &stamp);
+                const MetricSample &sample);
+
+        void report_summary(
+                std::string_view name,
+                std::string_view help,
+                const turbo::flat_hash_map<std::string, std::string> &tags,
+                const MetricSample &sample);
 
         void report_flag(
                 std::string_view name,
@@ -15,6 +15,7 @@
 
 #include <tally/reporters/prometheus_stats_reporter.h>
 #include <turbo/log/logging.h>
+#include <iomanip>
 
 namespace tally {
 
@@ -23,7 +24,7 @@ namespace tally {
         // Write a double as a string, with proper formatting for infinity and NaN
         void WriteValue(std::ostream &out, double value) {
             if (std::isnan(value)) {
-                out << "Nan";
+                out << "NaN";
             } else if (std::isinf(value)) {
                 out << (value < 0 ? "-Inf" : "+Inf");
             } else {
@@ -61,7 +62,7 @@ namespace tally {
                   const std::string &extraLabelName = "",
                   const T &extraLabelValue = T()) {
             out << name << suffix;
-            if (tags.empty() || !extraLabelName.empty()) {
+            if (!tags.empty() || !extraLabelName.empty()) {
                 out << "{";
                 const char *prefix = "";
 
@@ -90,22 +91,108 @@ namespace tally {
             out << "\n";
         }
 
+        // OpenMetrics timestamps are seconds since epoch.
+        void WriteSeconds(std::ostream &out, const turbo::Time &stamp) {
+            auto mls = turbo::Time::to_milliseconds(stamp);
+            out << mls / 1000 << '.' << std::setw(3) << std::setfill('0') << mls % 1000 << std::setfill(' ');
+        }
+
+        void WriteOpenMetricsTail(std::ostream &out, const turbo::Time &stamp) {
+            if (turbo::Time::to_milliseconds(stamp) != 0) {
+                out << " ";
+                WriteSeconds(out, stamp);
+            }
+            out << "\n";
+        }
+
+        // Write ` # {labels} value timestamp` after a bucket sample.
+        void WriteExemplar(std::ostream &out, const Exemplar &exemplar) {
+            out << " # {";
+            const char *prefix = "";
+            for (auto &lp: exemplar.labels) {
+                out << prefix << lp.first << "=\"";
+                WriteValue(out, lp.second);
+                out << "\"";
+                prefix = ",";
+            }
+            out << "} ";
+            WriteValue(out, exemplar.value);
+            out << " ";
+            WriteSeconds(out, exemplar.timestamp);
+        }
+
+        std::string_view CounterFamily(std::string_view name) {
+            constexpr std::string_view kTotal = "_total";
+            if (name.size() > kTotal.size() && name.substr(name.size() - kTotal.size()) == kTotal) {
+                name.remove_suffix(kTotal.size());
+            }
+            return name;
+        }
+
     }  // namespace
 
+    void PrometheusStatsReporter::write_metadata(std::string_view family,
+                                                 std::string_view help,
+                                                 std::string_view type,
+                                                 const Variable *v) {
+        if (!help.empty()) {
+            _os << "# HELP " << family << " ";
+            if (_open_metrics) {
+                WriteValue(_os, std::string(help));
+            } else {
+                _os << help;
+            }
+            _os << "\n";
+        }
+        _os << "# TYPE " << family << " " << type << "\n";
+        auto &unit = v->unit();
+        if (_open_metrics && !unit.empty() && family.size() > unit.size() + 1 &&
+            family.substr(family.size() - unit.size()) == unit &&
+            family[family.size() - unit.size() - 1] == '_') {
+            _os << "# UNIT " << family << " " << unit << "\n";
+        }
+    }
+
+    void PrometheusStatsReporter::write_created(std::string_view family,
+                                                const turbo::flat_hash_map<std::string, std::string> &tags,
+                                                const Variable *v) {
+        if (turbo::Time::to_milliseconds(v->created_time()) == 0) {
+            return;
+        }
+        WriteHead(_os, family, tags, "_created");
+        WriteSeconds(_os, v->created_time());
+        _os << "\n";
+    }
+
     void PrometheusStatsReporter::report_counter(
             std::string_view name,
             std::string_view help,
             const turbo::flat_hash_map<std::string, std::string> &tags, const Variable* v, const turbo::Time &stamp) {
         state.counter_count++;
-        MetricSample sample = v->get_metric(stamp);
-        auto value = std::get<double>(sample.value);
-        if (!help.empty()) {
-            _os << "# HELP " << name << " " << help << "\n";
+        turbo::flat_hash_map<std::string, std::string> scratch;
+        std::vector<VariableChild> children;
+        v->children(stamp, &children);
+        if (_open_metrics) {
+            auto family = CounterFamily(name);
+            write_metadata(family, help, "counter", v);
+            for (auto &child: children) {
+                auto &child_tags = Variable::child_tags(child, tags, &scratch);
+                auto &sample = child.sample;
+                WriteHead(_os, family, child_tags, "_total");
+                WriteValue(_os, std::get<double>(sample.value));
+                WriteOpenMetricsTail(_os, sample.timestamp);
+                write_created(family, child_tags, v);
+            }
+            return;
+        }
+        write_metadata(name, help, "counter", v);
+        for (auto &child: children) {
+            auto &child_tags = Variable::child_tags(child, tags, &scratch);
+            auto &sample = child.sample;
+            WriteHead(_os, name, child_tags);
+            WriteValue(_os, std::get<double>(sample.value));
+            WriteTail(_os, sample.timestamp);
         }
-        _os << "# TYPE " << name << " counter\n";
-        WriteHead(_os, name, tags);
-        WriteValue(_os, value);
-        WriteTail(_os, sample.timestamp);
     }
 
     void PrometheusStatsReporter::report_gauge(
@@ -113,15 +200,21 @@ namespace tally {
             std::string_view help,
             const turbo::flat_hash_map<std::string, std::string> &tags, const Variable* v, const turbo::Time &stamp) {
         state.gauge_count++;
-        MetricSample sample = v->get_metric(stamp);
-        auto value = std::get<double>(sample.value);
-        if (!help.empty()) {
-            _os << "# HELP " << name << " " << help << "\n";
+        write_metadata(name, help, "gauge", v);
+        turbo::flat_hash_map<std::string, std::string> scratch;
+        std::vector<VariableChild> children;
+        v->children(stamp, &children);
+        for (auto &child: children) {
+            auto &child_tags = Variable::child_tags(child, tags, &scratch);
+            auto &sample = child.sample;
+            WriteHead(_os, name, child_tags);
+            WriteValue(_os, std::get<double>(sample.value));
+            if (_open_metrics) {
+                WriteOpenMetricsTail(_os, sample.timestamp);
+            } else {
+                WriteTail(_os, sample.timestamp);
+            }
         }
-        _os << "# TYPE " << name << " gauge\n";
-        WriteHead(_os, name, tags);
-        WriteValue(_os, value);
-        WriteTail(_os, sample.timestamp);
     }
 
     void PrometheusStatsReporter::report_histogram(
@@ -130,30 +223,99 @@ namespace tally {
             const turbo::flat_hash_map<std::string, std::string> &tags,
             const Variable* v, const turbo::Time &stamp) {
         state.hist_count++;
-        MetricSample sample = v->get_metric(stamp);
-        auto hist = std::get<HistogramSample>(sample.value);
-        if (!help.empty()) {
-            _os << "# HELP " << name << " " << help << "\n";
-        }
-        _os << "# TYPE " << name << " histogram\n";
-        WriteHead(_os, name, tags, "_sum");
-        WriteValue(_os, hist.sample_sum);
-        WriteTail(_os, zo);
-
-        double last = -std::numeric_limits<double>::infinity();
-        for (auto &b: hist.buckets) {
-            WriteHead(_os, name, tags, "_bucket", "le", b.upper_bound);
-            last = b.upper_bound;
-            _os << b.value;
+        write_metadata(name, help, "histogram", v);
+        turbo::flat_hash_map<std::string, std::string> scratch;
+        std::vector<VariableChild> children;
+        v->children(stamp, &children);
+        for (auto &child: children) {
+            auto &child_tags = Variable::child_tags(child, tags, &scratch);
+            auto &sample = child.sample;
+            auto hist = std::get<HistogramSample>(sample.value);
+            if (_open_metrics) {
+                // OpenMetrics buckets are cumulative and end with le="+Inf".
+                int64_t cumulative = 0;
+                for (size_t i = 0; i < hist.buckets.size(); ++i) {
+                    auto &b = hist.buckets[i];
+                    cumulative += b.value;
+                    if (i + 1 == hist.buckets.size() || b.upper_bound == std::numeric_limits<double>::max()) {
+                        WriteHead(_os, name, child_tags, "_bucket", "le", "+Inf");
+                    } else {
+                        WriteHead(_os, name, child_tags, "_bucket", "le", b.upper_bound);
+                    }
+                    _os << cumulative;
+                    if (i < hist.exemplars.size() && hist.exemplars[i]) {
+                        WriteExemplar(_os, *hist.exemplars[i]);
+                    }
+                    _os << "\n";
+                }
+                WriteHead(_os, name, child_tags, "_count");
+                _os << hist.sample_count << "\n";
+                WriteHead(_os, name, child_tags, "_sum");
+                WriteValue(_os, hist.sample_sum);
+                _os << "\n";
+                write_created(name, child_tags, v);
+                continue;
+            }
+            WriteHead(_os, name, child_tags, "_sum");
+            WriteValue(_os, hist.sample_sum);
             WriteTail(_os, zo);
+
+            double last = -std::numeric_limits<double>::infinity();
+            for (auto &b: hist.buckets) {
+                WriteHead(_os, name, child_tags, "_bucket", "le", b.upper_bound);
+                last = b.upper_bound;
+                _os << b.value;
+                WriteTail(_os, zo);
+            }
+
+            if (last != std::numeric_limits<double>::infinity() && last != std::numeric_limits<double>::max()) {
+                WriteHead(_os, name, child_tags, "_bucket", "le", "+Inf");
+            }
+            WriteHead(_os, name, child_tags, "_count");
+            _os << hist.sample_count;
+            WriteTail(_os, sample.timestamp);
         }
+    }
 
-        if (last != std::numeric_limits<double>::infinity() && last != std::numeric_limits<double>::max()) {
-            WriteHead(_os, name, tags, "_bucket", "le", "+Inf");
+    void PrometheusStatsReporter::report_summary(
+            std::string_view name,
+            std::string_view help,
+            const turbo::flat_hash_map<std::string, std::string> &tags,
+            const Variable* v, const turbo::Time &stamp) {
+        state.summary_count++;
+        write_metadata(name, help, "summary", v);
+        turbo::flat_hash_map<std::string, std::string> scratch;
+        std::vector<VariableChild> children;
+        v->children(stamp, &children);
+        for (auto &child: children) {
+            auto &child_tags = Variable::child_tags(child, tags, &scratch);
+            auto &sample = child.sample;
+            auto &summary = std::get<SummarySample>(sample.value);
+            for (auto &q: summary.quantiles) {
+                WriteHead(_os, name, child_tags, "", "quantile", q.first);
+                WriteValue(_os, q.second);
+                if (_open_metrics) {
+                    WriteOpenMetricsTail(_os, sample.timestamp);
+                } else {
+                    WriteTail(_os, sample.timestamp);
+                }
+            }
+            WriteHead(_os, name, child_tags, "_sum");
+            WriteValue(_os, summary.sample_sum);
+            if (_open_metrics) {
+                WriteOpenMetricsTail(_os, sample.timestamp);
+            } else {
+                WriteTail(_os, sample.timestamp);
+            }
+            WriteHead(_os, name, child_tags, "_count");
+            _os << summary.sample_count;
+            if (_open_metrics) {
+                WriteOpenMetricsTail(_os, sample.timestamp);
+                write_created(name, child_tags, v);
+            } else {
+                WriteTail(_os, sample.timestamp);
+            }
         }
-        WriteHead(_os, name, tags, "_count");
-        _os << hist.sample_count;
-        WriteTail(_os, sample.timestamp);
     }
 
     void PrometheusStatsReporter::report_variable(
@@ -166,7 +328,6 @@ namespace tally {
         auto &name = var->full_name();
         auto &help = var->help();
         auto &tags = var->tags();
-        MetricSample ms = var->get_metric(stamp);
         if (var->type().is_gauge()) {
             report_gauge(name, help, tags, var, stamp);
         } else if (var->type().is_counter()) {
@@ -174,6 +335,8 @@ namespace tally {
         }
         if (var->type().is_histogram()) {
             report_histogram(name, help, tags, var, stamp);
+        } else if (var->type().is_summary()) {
+            report_summary(name, help, tags, var, stamp);
         }
     }
 
@@ -22,15 +22,30 @@
 
 namespace tally {
 
+    // Writes metrics in the prometheus text format, or in the OpenMetrics
+    // text format when `open_metrics' is true. The OpenMetrics output adds
+    // `_total' and `_created' samples, unit metadata and histogram exemplars,
+    // and must be terminated by flush() which writes the `# EOF' line.
     class PrometheusStatsReporter : public StatsReporter {
     public:
-        PrometheusStatsReporter(std::ostream &os) : _os(os) {
-            set_name("prometheus");
-            set_help("prometheus metric text reporter");
+        static constexpr std::string_view kContentType = "text/plain; version=0.0.4; charset=utf-8";
+        static constexpr std::string_view kOpenMetricsContentType =
+                "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+        PrometheusStatsReporter(std::ostream &os, bool open_metrics = false) : _os(os), _open_metrics(open_metrics) {
+            set_name(open_metrics ? "openmetrics" : "prometheus");
+            set_help(open_metrics ? "openmetrics text reporter" : "prometheus metric text reporter");
         }
 
         void flush() override {
            //state = ReportState{};
+            if (_open_metrics) {
+                _os << "# EOF\n";
+            }
+        }
+
+        bool open_metrics() const {
+            return _open_metrics;
         }
 
         void describe(std::ostream &os) const override {
@@ -41,6 +56,7 @@ namespace tally {
             os<<"gauge: "<<state.gauge_count<<"\n";
             os<<"counter: "<<state.counter_count<<"\n";
             os<<"histogram: "<<state.hist_count<<"\n";
+            os<<"summary: "<<state.summary_count<<"\n";
             os<<"not metric: "<<state.no_metric_count<<"\n";
             os<<"filter off: "<<state.discard_count<<"\n";
         }
@@ -69,8 +85,24 @@ namespace tally {
                 std::string_view help,
                 const turbo::flat_hash_map<std::string, std::string> &tags,
                 const Variable *value, const turbo::Time &stamp);
+
+        void report_summary(
+                std::string_view name,
+                std::string_view help,
+                const turbo::flat_hash_map<std::string, std::string> &tags,
+                const Variable *value, const turbo::Time &stamp);
+
+        void write_metadata(std::string_view family,
+                            std::string_view help,
+                            std::string_view type,
+                            const Variable *value);
+
+        void write_created(std::string_view family,
+                           const turbo::flat_hash_map<std::string, std::string> &tags,
+                           const Variable *value);
     private:
         std::ostream &_os;
+        bool _open_metrics{false};
     };
 
 }  // namespace tally
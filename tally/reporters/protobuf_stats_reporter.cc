@@ -0,0 +1,282 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/reporters/protobuf_stats_reporter.h>
+#include <cmath>
+#include <limits>
+
+namespace tally {
+
+    namespace {
+        // Field numbers of io.prometheus.client messages, see metrics.proto
+        // of prometheus/client_model.
+        enum MetricType {
+            kCounterType = 0,
+            kGaugeType = 1,
+            kSummaryType = 2,
+            kUntypedType = 3,
+            kHistogramType = 4,
+        };
+
+        constexpr uint32_t kLabelPairName = 1;
+        constexpr uint32_t kLabelPairValue = 2;
+
+        constexpr uint32_t kGaugeValue = 1;
+
+        constexpr uint32_t kCounterValue = 1;
+        constexpr uint32_t kCounterCreated = 3;
+
+        constexpr uint32_t kSummarySampleCount = 1;
+        constexpr uint32_t kSummarySampleSum = 2;
+        constexpr uint32_t kSummaryQuantile = 3;
+        constexpr uint32_t kSummaryCreated = 4;
+
+        constexpr uint32_t kQuantileQuantile = 1;
+        constexpr uint32_t kQuantileValue = 2;
+
+        constexpr uint32_t kHistogramSampleCount = 1;
+        constexpr uint32_t kHistogramSampleSum = 2;
+        constexpr uint32_t kHistogramBucket = 3;
+        constexpr uint32_t kHistogramCreated = 15;
+
+        constexpr uint32_t kBucketCumulativeCount = 1;
+        constexpr uint32_t kBucketUpperBound = 2;
+        constexpr uint32_t kBucketExemplar = 3;
+
+        constexpr uint32_t kExemplarLabel = 1;
+        constexpr uint32_t kExemplarValue = 2;
+        constexpr uint32_t kExemplarTimestamp = 3;
+
+        constexpr uint32_t kMetricLabel = 1;
+        constexpr uint32_t kMetricGauge = 2;
+        constexpr uint32_t kMetricCounter = 3;
+        constexpr uint32_t kMetricSummary = 4;
+        constexpr uint32_t kMetricTimestampMs = 6;
+        constexpr uint32_t kMetricHistogram = 7;
+
+        constexpr uint32_t kFamilyName = 1;
+        constexpr uint32_t kFamilyHelp = 2;
+        constexpr uint32_t kFamilyType = 3;
+        constexpr uint32_t kFamilyMetric = 4;
+        constexpr uint32_t kFamilyUnit = 5;
+
+        constexpr uint32_t kTimestampSeconds = 1;
+        constexpr uint32_t kTimestampNanos = 2;
+
+        void WriteLabelPair(ProtobufWriter &out, uint32_t field, ProtobufWriter &scratch,
+                            std::string_view name, std::string_view value) {
+            scratch.clear();
+            scratch.write_bytes(kLabelPairName, name);
+            scratch.write_bytes(kLabelPairValue, value);
+            out.write_message(field, scratch);
+        }
+
+        // google.protobuf.Timestamp
+        void WriteTimestamp(ProtobufWriter &out, uint32_t field, ProtobufWriter &scratch,
+                            const turbo::Time &stamp) {
+            auto us = turbo::Time::to_microseconds(stamp);
+            auto seconds = us / 1000000;
+            auto nanos = (us % 1000000) * 1000;
+            if (nanos < 0) {
+                seconds -= 1;
+                nanos += 1000000000;
+            }
+            scratch.clear();
+            scratch.write_int64(kTimestampSeconds, seconds);
+            scratch.write_int64(kTimestampNanos, nanos);
+            out.write_message(field, scratch);
+        }
+
+        bool HasTime(const turbo::Time &stamp) {
+            return turbo::Time::to_milliseconds(stamp) != 0;
+        }
+
+        // Like the OpenMetrics text format, the unit is only announced when
+        // the family name carries it as suffix.
+        bool HasUnitSuffix(std::string_view family, std::string_view unit) {
+            return !unit.empty() && family.size() > unit.size() + 1 &&
+                   family.substr(family.size() - unit.size()) == unit &&
+                   family[family.size() - unit.size() - 1] == '_';
+        }
+    }  // namespace
+
+    void ProtobufStatsReporter::write_labels(const Variable *v, const VariableChild &child) {
+        for (auto &lp: Variable::child_tags(child, v->tags(), &_tags)) {
+            WriteLabelPair(_metric, kMetricLabel, _sub, lp.first, lp.second);
+        }
+    }
+
+    void ProtobufStatsReporter::begin_family(const Variable *v, int type) {
+        _family.clear();
+        _family.write_bytes(kFamilyName, v->full_name());
+        if (!v->help().empty()) {
+            _family.write_bytes(kFamilyHelp, v->help());
+        }
+        _family.write_int64(kFamilyType, type);
+    }
+
+    void ProtobufStatsReporter::add_metric() {
+        _family.write_message(kFamilyMetric, _metric);
+    }
+
+    void ProtobufStatsReporter::end_family(const Variable *v) {
+        if (HasUnitSuffix(v->full_name(), v->unit())) {
+            _family.write_bytes(kFamilyUnit, v->unit());
+        }
+        _out.clear();
+        _out.write_delimited(_family);
+        _os.write(_out.buffer().data(), static_cast<std::streamsize>(_out.size()));
+    }
+
+    void ProtobufStatsReporter::report_counter(const Variable *v, const turbo::Time &stamp) {
+        state.counter_count++;
+        begin_family(v, kCounterType);
+        v->children(stamp, &_children);
+        for (auto &child: _children) {
+            auto &sample = child.sample;
+            _value.clear();
+            _value.write_double(kCounterValue, std::get<double>(sample.value));
+            if (HasTime(v->created_time())) {
+                WriteTimestamp(_value, kCounterCreated, _sub, v->created_time());
+            }
+            _metric.clear();
+            write_labels(v, child);
+            _metric.write_message(kMetricCounter, _value);
+            if (HasTime(sample.timestamp)) {
+                _metric.write_int64(kMetricTimestampMs, turbo::Time::to_milliseconds(sample.timestamp));
+            }
+            add_metric();
+        }
+        end_family(v);
+    }
+
+    void ProtobufStatsReporter::report_gauge(const Variable *v, const turbo::Time &stamp) {
+        state.gauge_count++;
+        begin_family(v, kGaugeType);
+        v->children(stamp, &_children);
+        for (auto &child: _children) {
+            auto &sample = child.sample;
+            _value.clear();
+            _value.write_double(kGaugeValue, std::get<double>(sample.value));
+            _metric.clear();
+            write_labels(v, child);
+            _metric.write_message(kMetricGauge, _value);
+            if (HasTime(sample.timestamp)) {
+                _metric.write_int64(kMetricTimestampMs, turbo::Time::to_milliseconds(sample.timestamp));
+            }
+            add_metric();
+        }
+        end_family(v);
+    }
+
+    void ProtobufStatsReporter::report_histogram(const Variable *v, const turbo::Time &stamp) {
+        state.hist_count++;
+        begin_family(v, kHistogramType);
+        v->children(stamp, &_children);
+        for (auto &child: _children) {
+            auto &sample = child.sample;
+            auto &hist = std::get<HistogramSample>(sample.value);
+            _value.clear();
+            _value.write_uint64(kHistogramSampleCount, static_cast<uint64_t>(hist.sample_count));
+            _value.write_double(kHistogramSampleSum, hist.sample_sum);
+            // Buckets of the protobuf format are cumulative, the catch-all
+            // bucket becomes +Inf.
+            int64_t cumulative = 0;
+            for (size_t i = 0; i < hist.buckets.size(); ++i) {
+                auto &b = hist.buckets[i];
+                cumulative += b.value;
+                double upper = b.upper_bound;
+                if (i + 1 == hist.buckets.size() || upper == std::numeric_limits<double>::max()) {
+                    upper = std::numeric_limits<double>::infinity();
+                }
+                _item.clear();
+                _item.write_uint64(kBucketCumulativeCount, static_cast<uint64_t>(cumulative));
+                _item.write_double(kBucketUpperBound, upper);
+                if (i < hist.exemplars.size() && hist.exemplars[i]) {
+                    auto &e = *hist.exemplars[i];
+                    _exemplar.clear();
+                    for (auto &lp: e.labels) {
+                        WriteLabelPair(_exemplar, kExemplarLabel, _sub, lp.first, lp.second);
+                    }
+                    _exemplar.write_double(kExemplarValue, e.value);
+                    WriteTimestamp(_exemplar, kExemplarTimestamp, _sub, e.timestamp);
+                    _item.write_message(kBucketExemplar, _exemplar);
+                }
+                _value.write_message(kHistogramBucket, _item);
+            }
+            if (HasTime(v->created_time())) {
+                WriteTimestamp(_value, kHistogramCreated, _sub, v->created_time());
+            }
+            _metric.clear();
+            write_labels(v, child);
+            _metric.write_message(kMetricHistogram, _value);
+            if (HasTime(sample.timestamp)) {
+                _metric.write_int64(kMetricTimestampMs, turbo::Time::to_milliseconds(sample.timestamp));
+            }
+            add_metric();
+        }
+        end_family(v);
+    }
+
+    void ProtobufStatsReporter::report_summary(const Variable *v, const turbo::Time &stamp) {
+        state.summary_count++;
+        begin_family(v, kSummaryType);
+        v->children(stamp, &_children);
+        for (auto &child: _children) {
+            auto &sample = child.sample;
+            auto &summary = std::get<SummarySample>(sample.value);
+            _value.clear();
+            _value.write_uint64(kSummarySampleCount, static_cast<uint64_t>(summary.sample_count));
+            _value.write_double(kSummarySampleSum, summary.sample_sum);
+            for (auto &q: summary.quantiles) {
+                _item.clear();
+                _item.write_double(kQuantileQuantile, q.first);
+                _item.write_double(kQuantileValue, q.second);
+                _value.write_message(kSummaryQuantile, _item);
+            }
+            if (HasTime(v->created_time())) {
+                WriteTimestamp(_value, kSummaryCreated, _sub, v->created_time());
+            }
+            _metric.clear();
+            write_labels(v, child);
+            _metric.write_message(kMetricSummary, _value);
+            if (HasTime(sample.timestamp)) {
+                _metric.write_int64(kMetricTimestampMs, turbo::Time::to_milliseconds(sample.timestamp));
+            }
+            add_metric();
+        }
+        end_family(v);
+    }
+
+    void ProtobufStatsReporter::report_variable(
+            const Variable *var, const turbo::Time &stamp) {
+        state.total++;
+        if (!var->type().is_metric()) {
+            state.no_metric_count++;
+            return;
+        }
+        if (var->type().is_gauge()) {
+            report_gauge(var, stamp);
+        } else if (var->type().is_counter()) {
+            report_counter(var, stamp);
+        }
+        if (var->type().is_histogram()) {
+            report_histogram(var, stamp);
+        } else if (var->type().is_summary()) {
+            report_summary(var, stamp);
+        }
+    }
+
+}  // namespace tally
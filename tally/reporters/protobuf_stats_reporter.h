@@ -0,0 +1,96 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <tally/stats_reporter.h>
+#include <tally/utility/protobuf_writer.h>
+
+namespace tally {
+
+    // Writes every metric as a length-delimited `io.prometheus.client.MetricFamily'
+    // message, the protobuf exposition format of prometheus. The encoding is
+    // hand written, see ProtobufWriter. Metrics, names, labels and values are
+    // the same as PrometheusStatsReporter writes.
+    class ProtobufStatsReporter : public StatsReporter {
+    public:
+        static constexpr std::string_view kContentType =
+                "application/vnd.google.protobuf; proto=io.prometheus.client.MetricFamily; encoding=delimited";
+
+        ProtobufStatsReporter(std::ostream &os) : _os(os) {
+            set_name("protobuf");
+            set_help("prometheus metric protobuf reporter");
+        }
+
+        void flush() override {
+            _os.flush();
+        }
+
+        void describe(std::ostream &os) const override {
+            os << "name: " << _name << "\n";
+            os << "help: " << _help << "\n";
+            os<<"collect:\n";
+            os<<"total: "<<state.total<<"\n";
+            os<<"gauge: "<<state.gauge_count<<"\n";
+            os<<"counter: "<<state.counter_count<<"\n";
+            os<<"histogram: "<<state.hist_count<<"\n";
+            os<<"summary: "<<state.summary_count<<"\n";
+            os<<"not metric: "<<state.no_metric_count<<"\n";
+            os<<"filter off: "<<state.discard_count<<"\n";
+        }
+
+        using StatsReporter::describe;
+
+        void report_variable(
+                const Variable *var, const turbo::Time &stamp) override;
+
+    private:
+        void report_counter(const Variable *value, const turbo::Time &stamp);
+
+        void report_gauge(const Variable *value, const turbo::Time &stamp);
+
+        void report_histogram(const Variable *value, const turbo::Time &stamp);
+
+        void report_summary(const Variable *value, const turbo::Time &stamp);
+
+        // Encode tags of `value' plus labels of `child' into `_metric'.
+        void write_labels(const Variable *value, const VariableChild &child);
+
+        // Start a MetricFamily of `value' in `_family'.
+        void begin_family(const Variable *value, int type);
+
+        // Add `_metric' to `_family'.
+        void add_metric();
+
+        // Finish `_family' and write it out delimited.
+        void end_family(const Variable *value);
+
+    private:
+        std::ostream &_os;
+        // Scratch buffers reused among variables.
+        ProtobufWriter _family;
+        ProtobufWriter _metric;
+        ProtobufWriter _value;
+        ProtobufWriter _item;
+        ProtobufWriter _exemplar;
+        ProtobufWriter _sub;
+        ProtobufWriter _out;
+        turbo::flat_hash_map<std::string, std::string> _tags;
+        std::vector<VariableChild> _children;
+    };
+
+}  // namespace tally
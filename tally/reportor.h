@@ -17,14 +17,25 @@
 
 #include <turbo/container/flat_hash_map.h>
 #include <tally/stats_reporter.h>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <tally/counter.h>
 #include <turbo/utility/status.h>
 #include <nlohmann/json.hpp>
 #include <tally/reporters/json_stats_reporter.h>
+#include <tally/utility/chunk_streambuf.h>
 
 namespace tally {
 
+    // Exposition formats a scraper may ask for with the Accept header.
+    enum class ExpositionFormat {
+        kPrometheusText,
+        kOpenMetricsText,
+        kProtobufDelimited,
+    };
+
     class Reporter {
     public:
 
@@ -53,6 +64,48 @@ namespace tally {
 
         static void get_prometheus_reporting(std::ostream &os, ReportOptions *options = nullptr);
 
+        static std::string get_openmetrics_reporting(ReportOptions *options = nullptr);
+
+        static void get_openmetrics_reporting(std::ostream &os, ReportOptions *options = nullptr);
+
+        static std::string get_protobuf_reporting(ReportOptions *options = nullptr);
+
+        static void get_protobuf_reporting(std::ostream &os, ReportOptions *options = nullptr);
+
+        // Pick the exposition format for the Accept header of a scrape
+        // request. Falls back to the prometheus text format.
+        static ExpositionFormat negotiate_format(std::string_view accept);
+
+        static std::string_view content_type(ExpositionFormat format);
+
+        static std::string get_reporting(ExpositionFormat format, ReportOptions *options = nullptr);
+
+        static void get_reporting(std::ostream &os, ExpositionFormat format, ReportOptions *options = nullptr);
+
+        // Stream the exposition into `sink' in chunks of at most `chunk_size'
+        // bytes as it is rendered, without holding the whole output. Returns
+        // false if the sink stopped the writing. Rendered by one thread
+        // whatever the parallelism of `options', so that at most one chunk
+        // is held at any time.
+        static bool stream_reporting(const ChunkSink &sink, ExpositionFormat format,
+                                     ReportOptions *options = nullptr, size_t chunk_size = 64 * 1024);
+
+        // Same as get_reporting(), but scrapes with the same format and
+        // filter within `max_age_ms' share one rendering. Scrapes missing
+        // the cache at the same time wait for the one in flight instead of
+        // rendering again. At most kMaxCachedReportings filters are kept,
+        // the stalest one is evicted for a new one. Hits and misses are
+        // exposed in the sys scope.
+        static std::shared_ptr<const std::string> get_cached_reporting(
+                ExpositionFormat format, ReportOptions *options = nullptr);
+
+        static std::shared_ptr<const std::string> get_cached_reporting(
+                ExpositionFormat format, ReportOptions *options, int64_t max_age_ms);
+
+        static void clear_reporting_cache();
+
+        static constexpr size_t kMaxCachedReportings = 64;
+
         static std::string get_json_reporting();
 
         static nlohmann::ordered_json get_json_reporting_json_format();
@@ -66,8 +119,26 @@ namespace tally {
     private:
         Reporter();
 
+        struct CachedReporting {
+            std::shared_ptr<const std::string> output;
+            int64_t rendered_us{0};
+            // bumped by every finished rendering.
+            uint64_t version{0};
+            bool rendering{false};
+        };
+
+        // Called with `_cache_mutex' held before adding an entry.
+        void evict_cached_reporting();
+
     private:
         std::shared_mutex _mutex;
         turbo::flat_hash_map<std::string, std::shared_ptr<StatsReporter>> _reporters;
+
+        std::mutex _cache_mutex;
+        std::condition_variable _cache_cond;
+        turbo::flat_hash_map<std::string, std::shared_ptr<CachedReporting>> _cache;
+        std::once_flag _cache_expose_once;
+        Counter<int64_t> _cache_hit;
+        Counter<int64_t> _cache_miss;
     };
 }  // namespace tally
@@ -16,6 +16,7 @@
 #include <tally/sigar_metric.h>
 #include <tally/config.h>
 #include <tally/scope.h>
+#include <algorithm>
 #include <mutex>
 
 namespace tally {
@@ -23,168 +24,69 @@ namespace tally {
     std::atomic<bool> SigarMetric::is_exposed{false};
 
     SigarMetric::SigarMetric()
-            : mem_ram([]() -> int64_t {
+            : mem_stats(6, [](double *values) {
         Sigar ar;
         SigarMem mem;
         auto rs = ar.get_mem(&mem);
         if (!rs.ok()) {
-            return 0;
+            std::fill(values, values + 6, 0);
+            return;
         }
-        return mem.ram;
+        values[0] = mem.ram;
+        values[1] = mem.total;
+        values[2] = mem.used;
+        values[3] = mem.free;
+        values[4] = mem.actual_used;
+        values[5] = mem.actual_free;
     }),
-              mem_total([]() -> int64_t {
-                  Sigar ar;
-                  SigarMem mem;
-                  auto rs = ar.get_mem(&mem);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return mem.total;
-              }),
-              mem_used([]() -> int64_t {
-                  Sigar ar;
-                  SigarMem mem;
-                  auto rs = ar.get_mem(&mem);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return mem.used;
-              }),
-              mem_free([]() -> int64_t {
-                  Sigar ar;
-                  SigarMem mem;
-                  auto rs = ar.get_mem(&mem);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return mem.free;
-              }),
-              mem_actual_used([]() -> int64_t {
-                  Sigar ar;
-                  SigarMem mem;
-                  auto rs = ar.get_mem(&mem);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return mem.actual_used;
-              }),
-              mem_actual_free([]() -> int64_t {
-                  Sigar ar;
-                  SigarMem mem;
-                  auto rs = ar.get_mem(&mem);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return mem.actual_free;
-              }),
-              swap_total([]() -> int64_t {
+              mem_ram(&mem_stats, 0),
+              mem_total(&mem_stats, 1),
+              mem_used(&mem_stats, 2),
+              mem_free(&mem_stats, 3),
+              mem_actual_used(&mem_stats, 4),
+              mem_actual_free(&mem_stats, 5),
+              swap_stats(3, [](double *values) {
                   Sigar ar;
                   SigarSwap swap;
                   auto rs = ar.get_swap(&swap);
                   if (!rs.ok()) {
-                      return 0;
+                      std::fill(values, values + 3, 0);
+                      return;
                   }
-                  return swap.total;
+                  values[0] = swap.total;
+                  values[1] = swap.used;
+                  values[2] = swap.free;
               }),
-              swap_used([]() -> int64_t {
-                  Sigar ar;
-                  SigarSwap swap;
-                  auto rs = ar.get_swap(&swap);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return swap.used;
-              }),
-              swap_free([]() -> int64_t {
-                  Sigar ar;
-                  SigarSwap swap;
-                  auto rs = ar.get_swap(&swap);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return swap.free;
-              }),
-              cpu_user([]() -> int64_t {
-                  Sigar ar;
-                  SigarCpu cpu;
-                  auto rs = ar.get_cpu(&cpu);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return cpu.user;
-              }),
-              cpu_sys([]() -> int64_t {
+              swap_total(&swap_stats, 0),
+              swap_used(&swap_stats, 1),
+              swap_free(&swap_stats, 2),
+              cpu_stats(9, [](double *values) {
                   Sigar ar;
                   SigarCpu cpu;
                   auto rs = ar.get_cpu(&cpu);
                   if (!rs.ok()) {
-                      return 0;
-                  }
-                  return cpu.sys;
-              }),
-              cpu_nice([]() -> int64_t {
-                  Sigar ar;
-                  SigarCpu cpu;
-                  auto rs = ar.get_cpu(&cpu);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return cpu.nice;
-              }),
-              cpu_idle([]() -> int64_t {
-                  Sigar ar;
-                  SigarCpu cpu;
-                  auto rs = ar.get_cpu(&cpu);
-                  if (!rs.ok()) {
-                      return 0;
+                      std::fill(values, values + 9, 0);
+                      return;
                   }
-                  return cpu.idle;
-              }),
-              cpu_wait([]() -> int64_t {
-                  Sigar ar;
-                  SigarCpu cpu;
-                  auto rs = ar.get_cpu(&cpu);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return cpu.wait;
-              }),
-              cpu_irq([]() -> int64_t {
-                  Sigar ar;
-                  SigarCpu cpu;
-                  auto rs = ar.get_cpu(&cpu);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return cpu.irq;
-              }),
-              cpu_soft_irq([]() -> int64_t {
-                  Sigar ar;
-                  SigarCpu cpu;
-                  auto rs = ar.get_cpu(&cpu);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return cpu.soft_irq;
-              }),
-              cpu_stolen([]() -> int64_t {
-                  Sigar ar;
-                  SigarCpu cpu;
-                  auto rs = ar.get_cpu(&cpu);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return cpu.stolen;
-              }),
-              cpu_total([]() -> int64_t {
-                  Sigar ar;
-                  SigarCpu cpu;
-                  auto rs = ar.get_cpu(&cpu);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return cpu.total;
+                  values[0] = cpu.user;
+                  values[1] = cpu.sys;
+                  values[2] = cpu.nice;
+                  values[3] = cpu.idle;
+                  values[4] = cpu.wait;
+                  values[5] = cpu.irq;
+                  values[6] = cpu.soft_irq;
+                  values[7] = cpu.stolen;
+                  values[8] = cpu.total;
               }),
+              cpu_user(&cpu_stats, 0),
+              cpu_sys(&cpu_stats, 1),
+              cpu_nice(&cpu_stats, 2),
+              cpu_idle(&cpu_stats, 3),
+              cpu_wait(&cpu_stats, 4),
+              cpu_irq(&cpu_stats, 5),
+              cpu_soft_irq(&cpu_stats, 6),
+              cpu_stolen(&cpu_stats, 7),
+              cpu_total(&cpu_stats, 8),
               uptime([]() -> double {
                   Sigar ar;
                   auto rs = ar.get_uptime();
@@ -193,57 +95,35 @@ namespace tally {
                   }
                   return rs.value_or_die();
               }),
-              loadavg_1m([]() -> double {
-                  Sigar ar;
-                  auto rs = ar.get_loadavg();
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return rs.value_or_die().loadavg[0];
-              }),
-              loadavg_5m([]() -> double {
+              loadavg_stats(3, [](double *values) {
                   Sigar ar;
                   auto rs = ar.get_loadavg();
                   if (!rs.ok()) {
-                      return 0;
+                      std::fill(values, values + 3, 0);
+                      return;
                   }
-                  return rs.value_or_die().loadavg[1];
+                  values[0] = rs.value_or_die().loadavg[0];
+                  values[1] = rs.value_or_die().loadavg[1];
+                  values[2] = rs.value_or_die().loadavg[2];
               }),
-              loadavg_15m([]() -> double {
-                  Sigar ar;
-                  auto rs = ar.get_loadavg();
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return rs.value_or_die().loadavg[2];
-              }),
-              disk_io_read([]() -> uint64_t {
+              loadavg_1m(&loadavg_stats, 0),
+              loadavg_5m(&loadavg_stats, 1),
+              loadavg_15m(&loadavg_stats, 2),
+              disk_io_stats(3, [](double *values) {
                   Sigar ar;
                   SigarProcDiskIO dio;
                   auto rs = ar.get_proc_disk_io(&dio);
                   if (!rs.ok()) {
-                      return 0;
+                      std::fill(values, values + 3, 0);
+                      return;
                   }
-                  return dio.bytes_read;
+                  values[0] = dio.bytes_read;
+                  values[1] = dio.bytes_written;
+                  values[2] = dio.bytes_total;
               }),
-              disk_io_write([]() -> uint64_t {
-                  Sigar ar;
-                  SigarProcDiskIO dio;
-                  auto rs = ar.get_proc_disk_io(&dio);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return dio.bytes_written;
-              }),
-              disk_io_total([]() -> uint64_t {
-                  Sigar ar;
-                  SigarProcDiskIO dio;
-                  auto rs = ar.get_proc_disk_io(&dio);
-                  if (!rs.ok()) {
-                      return 0;
-                  }
-                  return dio.bytes_total;
-              }){
+              disk_io_read(&disk_io_stats, 0),
+              disk_io_write(&disk_io_stats, 1),
+              disk_io_total(&disk_io_stats, 2) {
 
     }
 
@@ -17,6 +17,7 @@
 
 #include <tally/sigar.h>
 #include <tally/gauge.h>
+#include <tally/gauge_group.h>
 
 namespace tally {
 
@@ -39,41 +40,48 @@ namespace tally {
     public:
         static std::atomic<bool> is_exposed;
         Sigar _ar;
+        // Values read together share one system read per scrape, see
+        // GaugeGroup.
         // memory
+        GaugeGroup mem_stats;
         // static
-        FuncGauge<int64_t> mem_ram;
-        FuncGauge<int64_t> mem_total;
+        GroupGauge<int64_t> mem_ram;
+        GroupGauge<int64_t> mem_total;
         // dynamic
-        FuncGauge<int64_t> mem_used;
-        FuncGauge<int64_t> mem_free;
-        FuncGauge<int64_t> mem_actual_used;
-        FuncGauge<int64_t> mem_actual_free;
+        GroupGauge<int64_t> mem_used;
+        GroupGauge<int64_t> mem_free;
+        GroupGauge<int64_t> mem_actual_used;
+        GroupGauge<int64_t> mem_actual_free;
 
         // swap
-        FuncGauge<int64_t> swap_total;
-        FuncGauge<int64_t> swap_used;
-        FuncGauge<int64_t> swap_free;
+        GaugeGroup swap_stats;
+        GroupGauge<int64_t> swap_total;
+        GroupGauge<int64_t> swap_used;
+        GroupGauge<int64_t> swap_free;
 
         // sys cpu
-        FuncGauge<int64_t> cpu_user;
-        FuncGauge<int64_t> cpu_sys;
-        FuncGauge<int64_t> cpu_nice;
-        FuncGauge<int64_t> cpu_idle;
-        FuncGauge<int64_t> cpu_wait;
-        FuncGauge<int64_t> cpu_irq;
-        FuncGauge<int64_t> cpu_soft_irq;
-        FuncGauge<int64_t> cpu_stolen;
-        FuncGauge<int64_t> cpu_total;
+        GaugeGroup cpu_stats;
+        GroupGauge<int64_t> cpu_user;
+        GroupGauge<int64_t> cpu_sys;
+        GroupGauge<int64_t> cpu_nice;
+        GroupGauge<int64_t> cpu_idle;
+        GroupGauge<int64_t> cpu_wait;
+        GroupGauge<int64_t> cpu_irq;
+        GroupGauge<int64_t> cpu_soft_irq;
+        GroupGauge<int64_t> cpu_stolen;
+        GroupGauge<int64_t> cpu_total;
 
         FuncGauge<double> uptime;
 
-        FuncGauge<double> loadavg_1m;
-        FuncGauge<double> loadavg_5m;
-        FuncGauge<double> loadavg_15m;
+        GaugeGroup loadavg_stats;
+        GroupGauge<double> loadavg_1m;
+        GroupGauge<double> loadavg_5m;
+        GroupGauge<double> loadavg_15m;
 
-        FuncGauge<double> disk_io_read;
-        FuncGauge<double> disk_io_write;
-        FuncGauge<double> disk_io_total;
+        GaugeGroup disk_io_stats;
+        GroupGauge<double> disk_io_read;
+        GroupGauge<double> disk_io_write;
+        GroupGauge<double> disk_io_total;
 
     };
 
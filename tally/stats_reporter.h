@@ -66,6 +66,14 @@ namespace tally {
             return _interval_ms;
         }
 
+        const std::string &white_wildcards() const {
+            return _white_wildcards;
+        }
+
+        const std::string &black_wildcards() const {
+            return _black_wildcards;
+        }
+
         ReportOptions &quote_string(bool flag) {
             _quote_string = flag;
             return *this;
@@ -76,6 +84,17 @@ namespace tally {
             return *this;
         }
 
+        int32_t parallelism() const {
+            return _parallelism;
+        }
+
+        // Number of threads rendering the builtin expositions, 0 takes
+        // tally_report_parallelism.
+        ReportOptions &parallelism(int32_t n) {
+            _parallelism = n;
+            return *this;
+        }
+
         ReportOptions &build_filter(std::string_view white, std::string_view black, char question_mark = '?') {
             _question_mark = question_mark;
             _white_wildcards = white;
@@ -107,6 +126,8 @@ namespace tally {
         // schedule interval
         int32_t _interval_ms{0};
 
+        int32_t _parallelism{0};
+
         std::shared_ptr<WildcardMatcher> _w_matcher;
         std::shared_ptr<WildcardMatcher> _b_matcher;
     };
@@ -116,6 +137,7 @@ namespace tally {
         size_t gauge_count{0};
         size_t counter_count{0};
         size_t hist_count{0};
+        size_t summary_count{0};
         size_t no_metric_count{0};
         size_t discard_count{0};
     };
@@ -20,18 +20,28 @@
 #include <tally/gauge.h>
 #include <tally/counter.h>
 #include <tally/histogram.h>
+#include <tally/windowed_histogram.h>
 #include <tally/window.h>
 #include <tally/scope.h>
 #include <tally/flag.h>
 #include <tally/sigar.h>
 #include <tally/sigar_metric.h>
 #include <tally/config.h>
+#include <tally/time_unit.h>
 #include <tally/latency_recorder.h>
+#include <tally/fast_latency_recorder.h>
 #include <tally/scope_builder.h>
 #include <tally/reporters/prometheus_stats_reporter.h>
+#include <tally/reporters/protobuf_stats_reporter.h>
 #include <tally/reporters/json_stats_reporter.h>
 #include <tally/reporters/dump_json_stats_reporter.h>
 #include <tally/reporters/json_dumper.h>
 #include <tally/reportor.h>
 #include <tally/collector.h>
 #include <tally/lock_timer.h>
+#include <tally/local_batch.h>
+#include <tally/metric_array.h>
+#include <tally/meter.h>
+#include <tally/distinct_counter.h>
+#include <tally/top_k.h>
+#include <tally/gauge_group.h>
@@ -0,0 +1,41 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <turbo/times/time.h>
+
+namespace tally {
+
+    // Unit of durations recorded by recorders and timers. Microseconds keep
+    // latencies of rpc-alike operations small, nanoseconds resolve
+    // sub-microsecond in-memory operations.
+    enum class TimeUnit {
+        kMicroseconds,
+        kNanoseconds,
+    };
+
+    inline int64_t to_time_unit(turbo::Duration d, TimeUnit unit) {
+        const int64_t ns = turbo::Duration::to_nanoseconds(d);
+        return unit == TimeUnit::kNanoseconds ? ns : ns / 1000;
+    }
+
+    inline double to_double_time_unit(turbo::Duration d, TimeUnit unit) {
+        const double ns = static_cast<double>(turbo::Duration::to_nanoseconds(d));
+        return unit == TimeUnit::kNanoseconds ? ns : ns / 1000.0;
+    }
+
+}  // namespace tally
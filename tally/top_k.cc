@@ -0,0 +1,124 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/top_k.h>
+#include <tally/config.h>
+
+namespace tally {
+
+    // Keeps summaries of `window_size' ticks and the top entries merged
+    // from them.
+    class TopK::TopSampler : public detail::TickRingSampler<detail::SpaceSaving> {
+    public:
+        TopSampler(combiner_type *combiner, size_t k, size_t capacity, size_t window_size)
+                : TickRingSampler(window_size, detail::SpaceSaving(capacity)),
+                  _combiner(combiner), _k(k), _capacity(capacity),
+                  _top(std::make_shared<const std::vector<TopKEntry>>()) {}
+
+        std::shared_ptr<const std::vector<TopKEntry>> get_top() {
+            return read([this] { return _top; });
+        }
+
+    protected:
+        void take_tick(detail::SpaceSaving *oldest) override {
+            *oldest = _combiner->reset_all_agents();
+        }
+
+        void on_ticked() override {
+            detail::SpaceSaving window(_capacity);
+            for (auto &tick: ticks()) {
+                window.merge(tick);
+            }
+            _top = std::make_shared<const std::vector<TopKEntry>>(window.top(_k));
+        }
+
+    private:
+        combiner_type *_combiner;
+        const size_t _k;
+        const size_t _capacity;
+        std::shared_ptr<const std::vector<TopKEntry>> _top;
+    };
+
+    TopK::TopK(size_t k, time_t window_size, std::string_view label_name) noexcept
+            : Variable(VariableAttr::gauge_attr()), _k(std::max<size_t>(k, 1)),
+              _window_size(window_size > 0 ? window_size : turbo::get_flag(FLAGS_tally_dump_interval)),
+              _label_name(label_name),
+              _combiner(detail::SpaceSaving(4 * _k), detail::SpaceSaving(4 * _k)) {
+        _sampler = new TopSampler(&_combiner, _k, 4 * _k, _window_size);
+        _sampler->schedule();
+    }
+
+    TopK::TopK(size_t k, time_t window_size, std::string_view name, std::string_view help,
+               std::string_view label_name, turbo::Nonnull<Scope *> scope) noexcept
+            : TopK(k, window_size, label_name) {
+        auto rs = expose(name, help, scope);
+        if (!rs.ok()) {
+            KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                            << "expose TopK failed: " << name << "to scope" << scope->id();
+            KLOG(WARNING) << "expose TopK failed: " << name << "to scope" << scope->id();
+        }
+    }
+
+    TopK::~TopK() {
+        hide();
+        _sampler->destroy();
+        _sampler = nullptr;
+    }
+
+    void TopK::add(const std::string &key, int64_t weight) {
+        auto *agent = _combiner.get_or_create_tls_agent();
+        if (TURBO_UNLIKELY(!agent)) {
+            KLOG(FATAL) << "Fail to create agent";
+            return;
+        }
+        agent->element.modify(detail::SpaceSavingAdd(), std::make_pair(&key, weight));
+    }
+
+    std::shared_ptr<const std::vector<TopKEntry>> TopK::top() const {
+        return _sampler->get_top();
+    }
+
+    void TopK::describe(std::ostream &os, bool) const {
+        auto entries = top();
+        os << '{';
+        for (size_t i = 0; i < entries->size(); ++i) {
+            auto &e = (*entries)[i];
+            if (i) {
+                os << ' ';
+            }
+            os << e.key << '=' << e.count;
+        }
+        os << '}';
+    }
+
+    MetricSample TopK::get_metric(const turbo::Time &stamp) const {
+        auto entries = top();
+        return {type(), entries->empty() ? 0.0 : static_cast<double>(entries->front().count), stamp};
+    }
+
+    void TopK::children(const turbo::Time &stamp, std::vector<VariableChild> *children) const {
+        auto entries = top();
+        children->resize(2 * entries->size());
+        for (size_t i = 0; i < children->size(); ++i) {
+            auto &e = (*entries)[i / 2];
+            auto &child = (*children)[i];
+            child.labels.clear();
+            child.labels[_label_name] = e.key;
+            child.labels[std::string("stat")] = i % 2 == 0 ? "count" : "error";
+            child.sample = {type(), static_cast<double>(i % 2 == 0 ? e.count : e.error), stamp};
+        }
+    }
+
+}  // namespace tally
@@ -0,0 +1,101 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <memory>
+#include <tally/variable.h>
+#include <tally/scope.h>
+#include <tally/impl/combiner.h>
+#include <tally/impl/sampler.h>
+#include <tally/impl/space_saving.h>
+
+namespace tally {
+
+    // The `k' heaviest keys added in the recent `window_size' seconds, e.g.
+    // hottest tenants or SQL fingerprints. A thread adds keys into the
+    // Space-Saving summary of its agent, which tracks at most 8 * k keys.
+    // Every second a sampler takes the summaries of all threads as the
+    // summary of the tick, merges the summaries of the ticks in the window
+    // and keeps the top entries until the next tick, so keys added within
+    // the current second show up at the next tick.
+    //
+    // The top entries are exported as one gauge family labelled by the key
+    // and `stat', the estimated count or its error bound, e.g.
+    //   hot_tenants{tenant="a",stat="count"} 1200
+    //   hot_tenants{tenant="a",stat="error"} 3
+    // Example:
+    //   tally::TopK g_hot_tenants(20, 60, "hot_tenants", "requests by tenant", "tenant");
+    //   g_hot_tenants << tenant_id;
+    class TopK : public Variable {
+    public:
+        typedef detail::AgentCombiner<detail::SpaceSaving, detail::SpaceSaving,
+                detail::SpaceSavingMerge> combiner_type;
+
+        // A non-positive `window_size' takes FLAGS_tally_dump_interval.
+        explicit TopK(size_t k, time_t window_size = -1, std::string_view label_name = "key") noexcept;
+
+        TopK(size_t k, time_t window_size, std::string_view name, std::string_view help,
+             std::string_view label_name = "key",
+             turbo::Nonnull<Scope *> scope = ScopeInstance::instance()->get_default().get()) noexcept;
+
+        ~TopK() override;
+
+        TopK(const TopK &) = delete;
+        TopK &operator=(const TopK &) = delete;
+
+        void add(const std::string &key, int64_t weight = 1);
+
+        TopK &operator<<(const std::string &key) {
+            add(key, 1);
+            return *this;
+        }
+
+        size_t k() const { return _k; }
+
+        // In seconds.
+        time_t window_size() const { return _window_size; }
+
+        // Top entries of the window as of the last tick, heaviest first.
+        std::vector<TopKEntry> get_value() const { return *top(); }
+
+        void get_value(std::any *value) const override { *value = get_value(); }
+
+        void describe(std::ostream &os, bool quote_string) const override;
+
+        // Count of the heaviest key.
+        MetricSample get_metric(const turbo::Time &stamp) const override;
+
+        bool has_children() const override { return true; }
+
+        size_t num_children() const override { return 2 * top()->size(); }
+
+        // The count and the error of each top entry, all taken from the
+        // entries of one tick.
+        void children(const turbo::Time &stamp, std::vector<VariableChild> *children) const override;
+
+    private:
+        class TopSampler;
+
+        std::shared_ptr<const std::vector<TopKEntry>> top() const;
+
+        const size_t _k;
+        const time_t _window_size;
+        const std::string _label_name;
+        combiner_type _combiner;
+        TopSampler *_sampler;
+    };
+
+}  // namespace tally
@@ -0,0 +1,65 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/utility/asymmetric_fence.h>
+#include <cerrno>
+#include <turbo/log/logging.h>
+
+#if defined(__linux__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tally {
+
+#if defined(__linux__) && defined(__NR_membarrier)
+    namespace {
+        long membarrier(int cmd) {
+            return syscall(__NR_membarrier, cmd, 0, 0);
+        }
+    }  // namespace
+
+    bool AsymmetricFence::register_expedited() {
+        const long cmds = membarrier(MEMBARRIER_CMD_QUERY);
+        if (cmds < 0 || !(cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED)) {
+            return false;
+        }
+        return membarrier(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED) == 0;
+    }
+
+    void AsymmetricFence::heavy() {
+        if (TURBO_UNLIKELY(!expedited())) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return;
+        }
+        // Light sides only paid a compiler barrier, a full fence here
+        // doesn't order them. Nothing is left to fall back to.
+        if (membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) != 0) {
+            KLOG(FATAL) << "membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) failed after registration, errno="
+                        << errno;
+        }
+    }
+#else
+    bool AsymmetricFence::register_expedited() {
+        return false;
+    }
+
+    void AsymmetricFence::heavy() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+#endif
+
+}  // namespace tally
@@ -0,0 +1,52 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <atomic>
+#include <turbo/base/macros.h>
+
+namespace tally {
+
+    // A pair of fences ordering a store before a later load, like
+    // std::atomic_thread_fence(std::memory_order_seq_cst) on both sides, for
+    // protocols in which one side runs far more often than the other. The
+    // light side costs a compiler barrier and the heavy side costs a
+    // membarrier(2) which serializes every running thread of the process.
+    // Without membarrier(2), both sides are full fences. A membarrier(2)
+    // failing once registered is fatal, since the light sides can't be
+    // ordered after the fact.
+    class AsymmetricFence {
+    public:
+        static void light() {
+            if (TURBO_LIKELY(expedited())) {
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            } else {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        static void heavy();
+
+    private:
+        static bool expedited() {
+            static const bool registered = register_expedited();
+            return registered;
+        }
+
+        static bool register_expedited();
+    };
+
+}  // namespace tally
@@ -0,0 +1,77 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <streambuf>
+#include <string_view>
+
+namespace tally {
+
+    // Receives output chunk by chunk. Returning false stops the writing.
+    using ChunkSink = std::function<bool(std::string_view chunk)>;
+
+    // A streambuf which hands a fixed size buffer to a ChunkSink whenever
+    // it is full, so an ostream over it writes out with bounded memory.
+    // Bytes left in the buffer are handed out by pubsync(). Once the sink
+    // gives up, writes fail and the ostream goes bad.
+    class ChunkStreamBuf : public std::streambuf {
+    public:
+        ChunkStreamBuf(ChunkSink sink, size_t chunk_size)
+                : _sink(std::move(sink)), _chunk_size(chunk_size > 0 ? chunk_size : 1),
+                  _buf(new char[_chunk_size]) {
+            setp(_buf.get(), _buf.get() + _chunk_size);
+        }
+
+        bool ok() const {
+            return _ok;
+        }
+
+    protected:
+        int_type overflow(int_type ch) override {
+            if (!deliver()) {
+                return traits_type::eof();
+            }
+            if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        int sync() override {
+            return deliver() ? 0 : -1;
+        }
+
+    private:
+        bool deliver() {
+            const size_t n = pptr() - pbase();
+            if (_ok && n > 0) {
+                _ok = _sink(std::string_view(pbase(), n));
+            }
+            setp(_buf.get(), _buf.get() + _chunk_size);
+            return _ok;
+        }
+
+    private:
+        ChunkSink _sink;
+        size_t _chunk_size;
+        std::unique_ptr<char[]> _buf;
+        bool _ok{true};
+    };
+
+}  // namespace tally
@@ -0,0 +1,69 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/utility/cycle_timer.h>
+#include <tally/config.h>
+#include <unistd.h>
+#include <thread>
+
+#if TALLY_HAS_TSC
+#include <cpuid.h>
+#endif
+
+namespace tally {
+
+#if TALLY_HAS_TSC
+    namespace {
+        // CPUID.80000007H:EDX[8]
+        bool invariant_tsc() {
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+                return false;
+            }
+            return edx & (1u << 8);
+        }
+    }  // namespace
+#endif
+
+    std::atomic<int> CycleClock::s_state{CALIBRATING};
+    double CycleClock::s_ns_per_tick = 1.0;
+
+    void CycleClock::calibrate() {
+#if TALLY_HAS_TSC
+        if (invariant_tsc()) {
+            const int64_t ns0 = monotonic_ns();
+            const uint64_t tsc0 = __rdtsc();
+            ::usleep(10000);
+            const int64_t ns1 = monotonic_ns();
+            const uint64_t tsc1 = __rdtsc();
+            // The flag is read last, as late after the start of the process
+            // as possible.
+            if (tsc1 > tsc0 && ns1 > ns0 && turbo::get_flag(FLAGS_tally_use_tsc)) {
+                s_ns_per_tick = static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0);
+                s_state.store(USE_TSC, std::memory_order_release);
+                return;
+            }
+        }
+#endif
+        s_state.store(USE_MONOTONIC, std::memory_order_release);
+    }
+
+    // No timing waits for the calibration, nor does the first one.
+    const bool CycleClock::s_calibration_started = [] {
+        std::thread(&CycleClock::calibrate).detach();
+        return true;
+    }();
+
+}  // namespace tally
@@ -0,0 +1,137 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#include <turbo/base/macros.h>
+#include <turbo/times/time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TALLY_HAS_TSC 1
+#else
+#define TALLY_HAS_TSC 0
+#endif
+
+namespace tally {
+
+    // The clock of timing helpers of tally: TimeRecorder and the lock
+    // timers. Reading the TSC costs several cycles rather than a call to
+    // clock_gettime(). The TSC is used if the cpu says it is invariant,
+    // namely ticking at a constant rate across cores and power states, and
+    // FLAGS_tally_use_tsc is on when the calibration finishes. Ticks are
+    // converted to nanoseconds by a rate calibrated against the monotonic
+    // clock, which takes 10ms in a background thread started at static
+    // initialization. Until then, and if the TSC is not used, ticks are
+    // nanoseconds of the monotonic clock.
+    class CycleClock {
+    public:
+        // Ticks since an unspecified point.
+        static int64_t now() { return now(tsc_enabled()); }
+
+        // Same as now() but read after preceding instructions complete,
+        // which ends a timed section.
+        static int64_t now_ordered() { return now_ordered(tsc_enabled()); }
+
+        static int64_t to_nanoseconds(int64_t ticks) { return to_nanoseconds(ticks, tsc_enabled()); }
+
+        // True if ticks are read from the TSC, false until calibrated.
+        static bool tsc_enabled() {
+            return s_state.load(std::memory_order_acquire) == USE_TSC;
+        }
+
+        // Ticks of the TSC if `tsc' is true, nanoseconds of the monotonic
+        // clock otherwise. A section ends with the clock it started with,
+        // as the calibration may finish in between.
+        static int64_t now(bool tsc) {
+#if TALLY_HAS_TSC
+            if (TURBO_LIKELY(tsc)) {
+                return static_cast<int64_t>(__rdtsc());
+            }
+#endif
+            (void) tsc;
+            return monotonic_ns();
+        }
+
+        static int64_t now_ordered(bool tsc) {
+#if TALLY_HAS_TSC
+            if (TURBO_LIKELY(tsc)) {
+                unsigned int aux;
+                return static_cast<int64_t>(__rdtscp(&aux));
+            }
+#endif
+            (void) tsc;
+            return monotonic_ns();
+        }
+
+        // `tsc' must be true only if tsc_enabled() returned true.
+        static int64_t to_nanoseconds(int64_t ticks, bool tsc) {
+            return tsc ? static_cast<int64_t>(static_cast<double>(ticks) * s_ns_per_tick) : ticks;
+        }
+
+    private:
+        enum State : int {
+            CALIBRATING = 0,
+            USE_MONOTONIC = 1,
+            USE_TSC = 2
+        };
+
+        static void calibrate();
+
+        static int64_t monotonic_ns() {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return ts.tv_sec * 1000000000L + ts.tv_nsec;
+        }
+
+        // Constant-initialized, so valid for timings in static initializers
+        // of other files. s_ns_per_tick is written before s_state becomes
+        // USE_TSC.
+        static std::atomic<int> s_state;
+        static double s_ns_per_tick;
+        static const bool s_calibration_started;
+    };
+
+    // Time a section with CycleClock, like turbo::TimeCost.
+    class CycleTimer {
+    public:
+        CycleTimer()
+                : _tsc(CycleClock::tsc_enabled()), _start(CycleClock::now(_tsc)), _stop(_start) {}
+
+        void start() {
+            _tsc = CycleClock::tsc_enabled();
+            _start = CycleClock::now(_tsc);
+            _stop = _start;
+        }
+
+        void stop() { _stop = CycleClock::now_ordered(_tsc); }
+
+        // Between the last start() and stop().
+        int64_t n_elapsed() const { return CycleClock::to_nanoseconds(_stop - _start, _tsc); }
+
+        int64_t u_elapsed() const { return n_elapsed() / 1000; }
+
+        turbo::Duration elapsed() const { return turbo::Duration::nanoseconds(n_elapsed()); }
+
+    private:
+        bool _tsc;
+        int64_t _start;
+        int64_t _stop;
+    };
+
+}  // namespace tally
@@ -0,0 +1,110 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>                     // memcpy
+#include <string>
+#include <string_view>
+
+namespace tally {
+
+    // Appends protobuf wire format to a string. Only what the prometheus
+    // exposition needs is supported, which saves a dependency on the
+    // protobuf runtime. Nested messages are encoded into their own writer
+    // first and then appended with write_bytes().
+    class ProtobufWriter {
+    public:
+        enum WireType : uint32_t {
+            kVarint = 0,
+            kFixed64 = 1,
+            kLengthDelimited = 2,
+            kFixed32 = 5,
+        };
+
+        ProtobufWriter() = default;
+
+        void clear() {
+            _buf.clear();
+        }
+
+        const std::string &buffer() const {
+            return _buf;
+        }
+
+        size_t size() const {
+            return _buf.size();
+        }
+
+        void write_varint(uint64_t v) {
+            char tmp[10];
+            size_t n = 0;
+            while (v >= 0x80) {
+                tmp[n++] = static_cast<char>(v | 0x80);
+                v >>= 7;
+            }
+            tmp[n++] = static_cast<char>(v);
+            _buf.append(tmp, n);
+        }
+
+        void write_tag(uint32_t field, WireType type) {
+            write_varint((static_cast<uint64_t>(field) << 3) | type);
+        }
+
+        void write_uint64(uint32_t field, uint64_t v) {
+            write_tag(field, kVarint);
+            write_varint(v);
+        }
+
+        // int32/int64/enum are encoded as two's complement varint.
+        void write_int64(uint32_t field, int64_t v) {
+            write_uint64(field, static_cast<uint64_t>(v));
+        }
+
+        void write_double(uint32_t field, double v) {
+            uint64_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            write_tag(field, kFixed64);
+            char tmp[8];
+            for (int i = 0; i < 8; ++i) {
+                tmp[i] = static_cast<char>(bits >> (8 * i));
+            }
+            _buf.append(tmp, 8);
+        }
+
+        // string, bytes and embedded messages.
+        void write_bytes(uint32_t field, std::string_view v) {
+            write_tag(field, kLengthDelimited);
+            write_varint(v.size());
+            _buf.append(v.data(), v.size());
+        }
+
+        void write_message(uint32_t field, const ProtobufWriter &msg) {
+            write_bytes(field, msg.buffer());
+        }
+
+        // Varint length prefix followed by the message, as read by
+        // parseDelimitedFrom().
+        void write_delimited(const ProtobufWriter &msg) {
+            write_varint(msg.size());
+            _buf.append(msg.buffer());
+        }
+
+    private:
+        std::string _buf;
+    };
+
+}  // namespace tally
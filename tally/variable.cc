@@ -17,6 +17,7 @@
 #include <tally/scope.h>
 #include <turbo/log/logging.h>
 #include <tally/utility/normalize_name.h>
+#include <algorithm>
 #include <shared_mutex>
 #include <tally/stats_reporter.h>
 
@@ -123,6 +124,7 @@ namespace tally {
         }
         _help = help;
         _scope = scope;
+        _created_time = turbo::Time::current_time();
         _exposed = true;
         return turbo::OkStatus();
     }
@@ -256,7 +258,17 @@ namespace tally {
     }
 
     void Variable::report(turbo::Nonnull<StatsReporter *> reporter, const turbo::Time &stamp) {
-        for (size_t i = 0; i < SUB_MAP_COUNT; i++) {
+        report(reporter, stamp, 0, SUB_MAP_COUNT);
+    }
+
+    size_t Variable::registry_shard_count() {
+        return SUB_MAP_COUNT;
+    }
+
+    void Variable::report(turbo::Nonnull<StatsReporter *> reporter, const turbo::Time &stamp,
+                          size_t shard_begin, size_t shard_end) {
+        shard_end = std::min(shard_end, SUB_MAP_COUNT);
+        for (size_t i = shard_begin; i < shard_end; i++) {
             std::shared_lock lk(get_variable_maps().variable_locks[i]);
             auto &var_map = get_variable_maps().variable_maps[i];
             for (auto &it: var_map) {
@@ -19,7 +19,9 @@
 #include <string>
 #include <any>
 #include <variant>
+#include <optional>
 #include <turbo/utility/status.h>
+#include <turbo/times/time.h>
 #include <turbo/container/flat_hash_map.h>
 #include <tally/impl/histogram_bucket.h>
 #include <turbo/flags/declare.h>
@@ -46,7 +48,9 @@ namespace tally {
 
         static constexpr uint32_t kFlag = 1 << 3;
 
-        static constexpr uint32_t kMetric = kCounter | kGauge | kHistogram;
+        static constexpr uint32_t kSummary = 1 << 4;
+
+        static constexpr uint32_t kMetric = kCounter | kGauge | kHistogram | kSummary;
 
         static constexpr uint32_t kCDF = 1 << 26;
 
@@ -72,6 +76,10 @@ namespace tally {
             return VariableType{kHistogram};
         }
 
+        constexpr static VariableType summary_type() {
+            return VariableType{kSummary};
+        }
+
         constexpr static VariableType status_type() {
             return VariableType{kStatus};
         }
@@ -116,6 +124,10 @@ namespace tally {
             return type & kHistogram;
         }
 
+        [[nodiscard]] bool is_summary() const {
+            return type & kSummary;
+        }
+
         [[nodiscard]] bool is_flag() const {
             return type & kFlag;
         }
@@ -209,6 +221,10 @@ namespace tally {
             return VariableAttr{VariableType::histogram_type(), f};
         }
 
+        constexpr static VariableAttr summary_attr(DisplayFilter f = DisplayFilter::DISPLAY_ON_ALL) {
+            return VariableAttr{VariableType::summary_type(), f};
+        }
+
         constexpr static VariableAttr status_attr(DisplayFilter f = DisplayFilter::DISPLAY_ON_ALL) {
             return VariableAttr{VariableType::status_type(), f};
         }
@@ -242,19 +258,43 @@ namespace tally {
         DisplayFilter display_filter{DisplayFilter::DISPLAY_ON_ALL};
     };
 
+    // An exemplar links a single observation to out-of-band context such as
+    // a trace id. Only exported by the OpenMetrics format.
+    struct Exemplar {
+        turbo::flat_hash_map<std::string, std::string> labels;
+        double value{0};
+        turbo::Time timestamp;
+    };
+
     struct HistogramSample {
         std::vector<HistogramBucket> buckets;
         double sample_sum{0};
         int64_t sample_count{0};
+        // Latest exemplar of each bucket, indexed as `buckets`. Empty if no
+        // exemplar was ever recorded.
+        std::vector<std::optional<Exemplar>> exemplars;
 
         bool operator==(const HistogramSample &rhs) const {
             return sample_sum == rhs.sample_sum && sample_count == rhs.sample_count && buckets == rhs.buckets;
         }
     };
 
+    // Quantiles computed by the client, with sum and count of all
+    // observations, namely a prometheus summary.
+    struct SummarySample {
+        // (quantile, value) in ascending order of quantiles.
+        std::vector<std::pair<double, double>> quantiles;
+        double sample_sum{0};
+        int64_t sample_count{0};
+
+        bool operator==(const SummarySample &rhs) const {
+            return sample_sum == rhs.sample_sum && sample_count == rhs.sample_count && quantiles == rhs.quantiles;
+        }
+    };
+
     struct MetricSample {
         VariableType type;
-        std::variant<double, HistogramSample> value;
+        std::variant<double, HistogramSample, SummarySample> value;
         turbo::Time timestamp;
 
         bool operator==(const MetricSample &rhs) const {
@@ -266,6 +306,8 @@ namespace tally {
                     return std::get<double>(value) == std::get<double>(rhs.value);
                 } else if (type.is_histogram()) {
                     return std::get<HistogramSample>(value) == std::get<HistogramSample>(rhs.value);
+                } else if (type.is_summary()) {
+                    return std::get<SummarySample>(value) == std::get<SummarySample>(rhs.value);
                 }
                 return false;
             } catch (...) {
@@ -274,6 +316,13 @@ namespace tally {
         }
     };
 
+    // One child of a family, see Variable::children().
+    struct VariableChild {
+        // On top of the tags of the variable.
+        turbo::flat_hash_map<std::string, std::string> labels;
+        MetricSample sample;
+    };
+
     struct FlagSample {
         std::string help;
         std::string name;
@@ -301,6 +350,8 @@ namespace tally {
                     return std::any_cast<double>(value) == std::any_cast<double>(rhs.value);
                 } else if (type.is_histogram()) {
                     return std::any_cast<HistogramSample>(value) == std::any_cast<HistogramSample>(rhs.value);
+                } else if (type.is_summary()) {
+                    return std::any_cast<SummarySample>(value) == std::any_cast<SummarySample>(rhs.value);
                 } else if (type.is_status()) {
                     return std::any_cast<std::string>(value) == std::any_cast<std::string>(rhs.value);
                 } else if (type.is_flag()) {
@@ -348,6 +399,55 @@ namespace tally {
 
         }
 
+        // Variables exported as one family of labelled children, such as
+        // MetricArray, have children. Reporters take the children of a
+        // variable with one children() call, and report each child labelled
+        // by tags() plus its labels, even if there's only one child.
+        [[nodiscard]] virtual bool has_children() const {
+            return false;
+        }
+
+        [[nodiscard]] virtual size_t num_children() const {
+            return 1;
+        }
+
+        [[nodiscard]] virtual MetricSample get_child_metric(size_t index, const turbo::Time &stamp) const {
+            return get_metric(stamp);
+        }
+
+        virtual void child_labels(size_t index, turbo::flat_hash_map<std::string, std::string> *labels) const {
+        }
+
+        // Children reported with `stamp', which replace `children'. Takes
+        // child i from child_labels(i) and get_child_metric(i) by default.
+        // Variables whose children come and go, e.g. TopK, override it to
+        // take all children from one snapshot, so that a report never mixes
+        // up two of them.
+        virtual void children(const turbo::Time &stamp, std::vector<VariableChild> *children) const {
+            children->resize(num_children());
+            for (size_t i = 0; i < children->size(); ++i) {
+                auto &child = (*children)[i];
+                child.labels.clear();
+                child_labels(i, &child.labels);
+                child.sample = get_child_metric(i, stamp);
+            }
+        }
+
+        // `tags' plus the labels of `child', which are put in `scratch' if
+        // any.
+        [[nodiscard]] static const turbo::flat_hash_map<std::string, std::string> &
+        child_tags(const VariableChild &child, const turbo::flat_hash_map<std::string, std::string> &tags,
+                   turbo::flat_hash_map<std::string, std::string> *scratch) {
+            if (child.labels.empty()) {
+                return tags;
+            }
+            *scratch = tags;
+            for (auto &label: child.labels) {
+                (*scratch)[label.first] = label.second;
+            }
+            return *scratch;
+        }
+
         // Describe saved series as a json-string into the stream.
         // The output will be ploted by flot.js
         // Returns 0 on success, 1 otherwise(this variable does not save series).
@@ -379,6 +479,22 @@ namespace tally {
             return _help;
         }
 
+        // Time of the last successful expose, exported as `_created`
+        // by the OpenMetrics format.
+        [[nodiscard]] const turbo::Time &created_time() const {
+            return _created_time;
+        }
+
+        // Unit of the variable, e.g. "seconds" or "bytes". The OpenMetrics
+        // format only emits it when the full name ends with "_<unit>".
+        [[nodiscard]] const std::string &unit() const {
+            return _unit;
+        }
+
+        void set_unit(std::string_view unit) {
+            _unit = unit;
+        }
+
         [[nodiscard]] VariableType type() const {
             return _attr.type;
         }
@@ -436,6 +552,15 @@ namespace tally {
 
         static void report(turbo::Nonnull<StatsReporter *> reporter, const turbo::Time &stamp);
 
+        // The registry is split into shards, variables of different shards
+        // can be reported by different threads.
+        static size_t registry_shard_count();
+
+        // Report variables in shards [shard_begin, shard_end) of the registry.
+        // Reporting all shards in order is the same as report().
+        static void report(turbo::Nonnull<StatsReporter *> reporter, const turbo::Time &stamp,
+                           size_t shard_begin, size_t shard_end);
+
     protected:
         virtual turbo::Status expose_impl(std::string_view name, std::string_view help, turbo::Nonnull<Scope *> scope);
 
@@ -450,6 +575,8 @@ namespace tally {
         std::string _name;
         std::string _full_name;
         std::string _help;
+        std::string _unit;
+        turbo::Time _created_time;
         VariableAttr _attr{VariableAttr::empty_attr()};
         bool _exposed{false};
         Scope *_scope{nullptr};
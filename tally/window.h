@@ -16,6 +16,7 @@
 
 #include <limits>                                 // std::numeric_limits
 #include <cmath>                                 // round
+#include <turbo/times/time.h>
 #include <turbo/flags/declare.h>
 #include <tally/config.h>
 #include <turbo/log/logging.h>                         // KLOG
@@ -63,7 +64,7 @@ namespace tally {
                     if (series_freq == SERIES_IN_SECOND) {
                         // Get one-second window value for PerSecond<>, otherwise the
                         // "smoother" plot may hide peaks.
-                        _series.append(_owner->get_value(1));
+                        _series.append(_owner->get_value(_owner->samples_per_second()));
                     } else {
                         // Get the value inside the full window. "get_value(1)" is
                         // incorrect when users intend to see aggregated values of
@@ -86,6 +87,21 @@ namespace tally {
                 KCHECK_EQ(0, _sampler->set_window_size(_window_size));
             }
 
+            // Sample `var' every `period', which must divide one second, and
+            // cover `window' rounded up to periods. All windows of a variable
+            // must be sampled at the same period.
+            WindowBase(R *var, turbo::Duration window, turbo::Duration period)
+                    : Variable(VariableAttr::window_attr()), _var(var),
+                      _sampler(var->get_sampler()), _series_sampler(NULL) {
+                const int64_t period_us = turbo::Duration::to_microseconds(period);
+                KCHECK_EQ(0, _sampler->set_sampling_period_us(period_us));
+                const int64_t window_us = turbo::Duration::to_microseconds(window);
+                _window_size = window_us > 0 ? (window_us + period_us - 1) / period_us
+                                             : turbo::get_flag(FLAGS_tally_dump_interval) *
+                                               (detail::Sampler::DEFAULT_PERIOD_US / period_us);
+                KCHECK_EQ(0, _sampler->set_window_size(_window_size));
+            }
+
             ~WindowBase() {
                 hide();
                 if (_series_sampler) {
@@ -122,8 +138,17 @@ namespace tally {
 
             void get_value(std::any* value) const override { *value = get_value(); }
 
+            // In samples, which are seconds at the default sampling period.
             time_t window_size() const { return _window_size; }
 
+            turbo::Duration window() const {
+                return turbo::Duration::microseconds(_window_size * _sampler->sampling_period_us());
+            }
+
+            time_t samples_per_second() const {
+                return detail::Sampler::DEFAULT_PERIOD_US / _sampler->sampling_period_us();
+            }
+
 
             turbo::Status describe_series(std::ostream& os, const SeriesOptions& options) const override {
                 if (_series_sampler == nullptr) {
@@ -135,6 +160,11 @@ namespace tally {
                 return turbo::OkStatus();
             }
 
+            // Changes when a sample is taken.
+            int64_t latest_sample_time_us() const {
+                return _sampler->latest_time_us();
+            }
+
             void get_samples(std::vector<value_type> *samples) const {
                 samples->clear();
                 samples->reserve(_window_size);
@@ -162,7 +192,8 @@ namespace tally {
     }  // namespace detail
 
     // Get data within a time window.
-    // The time unit is 1 second fixed.
+    // The time unit is 1 second by default, or the sampling period given
+    // with the window duration.
     // Window relies on other tally which should be constructed before this window
     // and destructs after this window.
 
@@ -179,6 +210,8 @@ namespace tally {
         // of Window is largely affected by window_size while PerSecond is not.
         Window(R *var, time_t window_size) : Base(var, window_size) {}
 
+        Window(R *var, turbo::Duration window, turbo::Duration period) : Base(var, window, period) {}
+
         Window(std::string_view name, std::string_view help, R *var, time_t window_size, Scope* scope = ScopeInstance::instance()->get_default().get())
                 : Base(var, window_size) {
            auto rs = this->expose(name, help, scope);
@@ -188,6 +221,17 @@ namespace tally {
                 KLOG(WARNING) << "expose Adder failed: " << name << "to scope" << scope->id();
             }
         }
+
+        Window(std::string_view name, std::string_view help, R *var, turbo::Duration window, turbo::Duration period,
+               Scope* scope = ScopeInstance::instance()->get_default().get())
+                : Base(var, window, period) {
+            auto rs = this->expose(name, help, scope);
+            if (!rs.ok()) {
+                KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                                << "expose Window failed: " << name << "to scope" << scope->id();
+                KLOG(WARNING) << "expose Window failed: " << name << "to scope" << scope->id();
+            }
+        }
     };
 
     // Get data per second within a time window.
@@ -204,6 +248,9 @@ namespace tally {
 
         PerSecond(R *var, time_t window_size) : Base(var, window_size) {}
 
+        // A non-positive `window' takes turbo::get_flag(FLAGS_tally_dump_interval) seconds.
+        PerSecond(R *var, turbo::Duration window, turbo::Duration period) : Base(var, window, period) {}
+
         PerSecond(std::string_view name, std::string_view help, R *var, Scope* scope = ScopeInstance::instance()->get_default().get())
                 : Base(var, -1) {
             auto rs = this->expose(name, help, scope);
@@ -224,6 +271,17 @@ namespace tally {
             }
         }
 
+        PerSecond(std::string_view name, std::string_view help, R *var, turbo::Duration window,
+                  turbo::Duration period, Scope* scope = ScopeInstance::instance()->get_default().get())
+                : Base(var, window, period) {
+            auto rs = this->expose(name, help, scope);
+            if (!rs.ok()) {
+                KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                                << "expose PerSecond failed: " << name << "to scope" << scope->id();
+                KLOG(WARNING) << "expose PerSecond failed: " << name << "to scope" << scope->id();
+            }
+        }
+
         value_type get_value(time_t window_size) const override {
             detail::Sample<value_type> s;
             this->get_span(window_size, &s);
@@ -0,0 +1,168 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <tally/windowed_histogram.h>
+#include <tally/config.h>
+
+namespace tally {
+
+    // Deltas of the cumulative histogram in a tick.
+    struct WindowedHistogramTick {
+        std::vector<int64_t> counts;
+        double sum{0};
+    };
+
+    // Keeps deltas of the cumulative histogram per tick and their running
+    // total.
+    class WindowedHistogram::WindowSampler : public detail::TickRingSampler<WindowedHistogramTick> {
+    public:
+        WindowSampler(const Histogram *histogram, size_t num_buckets, time_t window_size)
+                : TickRingSampler(window_size, WindowedHistogramTick{std::vector<int64_t>(num_buckets, 0), 0}),
+                  _histogram(histogram), _num_buckets(num_buckets),
+                  _last_counts(num_buckets, 0), _last_sum(0),
+                  _total_counts(num_buckets, 0), _total_sum(0) {}
+
+        void get_counts(std::vector<int64_t> *counts, double *sum) {
+            read([&] {
+                *counts = _total_counts;
+                *sum = _total_sum;
+            });
+        }
+
+    protected:
+        void take_tick(WindowedHistogramTick *oldest) override {
+            auto buckets = _histogram->get_value();
+            const double sum = _histogram->sample_sum();
+            if (buckets.size() != _num_buckets) {
+                return;
+            }
+            for (size_t i = 0; i < _num_buckets; ++i) {
+                const int64_t delta = buckets[i].value - _last_counts[i];
+                _last_counts[i] = buckets[i].value;
+                _total_counts[i] += delta - oldest->counts[i];
+                oldest->counts[i] = delta;
+            }
+            const double delta_sum = sum - _last_sum;
+            _last_sum = sum;
+            _total_sum += delta_sum - oldest->sum;
+            oldest->sum = delta_sum;
+        }
+
+    private:
+        const Histogram *_histogram;
+        const size_t _num_buckets;
+        std::vector<int64_t> _last_counts;
+        double _last_sum;
+        std::vector<int64_t> _total_counts;
+        double _total_sum;
+    };
+
+    WindowedHistogram::WindowedHistogram(const Buckets &buckets, time_t window_size) noexcept
+            : Variable(VariableAttr::window_attr()), histogram_(buckets),
+              window_size_(window_size > 0 ? window_size : turbo::get_flag(FLAGS_tally_dump_interval)) {
+        sampler_ = new WindowSampler(&histogram_, histogram_.get_value().size(), window_size_);
+        sampler_->schedule();
+    }
+
+    WindowedHistogram::WindowedHistogram(const Buckets &buckets, time_t window_size, std::string_view name,
+                                         std::string_view help, turbo::Nonnull<Scope *> scope) noexcept
+            : WindowedHistogram(buckets, window_size) {
+        auto rs = expose(name, help, scope);
+        if (!rs.ok()) {
+            KLOG_IF(FATAL, turbo::get_flag(FLAGS_tally_crash_on_expose_fail))
+                            << "expose WindowedHistogram failed: " << name << "to scope" << scope->id();
+            KLOG(WARNING) << "expose WindowedHistogram failed: " << name << "to scope" << scope->id();
+        }
+    }
+
+    WindowedHistogram::~WindowedHistogram() {
+        hide();
+        sampler_->destroy();
+        sampler_ = nullptr;
+    }
+
+    HistogramSample WindowedHistogram::window_sample() const {
+        std::vector<int64_t> counts;
+        HistogramSample hs{histogram_.get_value(), 0, 0, {}};
+        sampler_->get_counts(&counts, &hs.sample_sum);
+        for (size_t i = 0; i < hs.buckets.size() && i < counts.size(); ++i) {
+            hs.buckets[i].value = counts[i];
+            hs.sample_count += counts[i];
+        }
+        return hs;
+    }
+
+    std::vector<HistogramBucket> WindowedHistogram::get_value() const {
+        return window_sample().buckets;
+    }
+
+    int64_t WindowedHistogram::count() const {
+        return window_sample().sample_count;
+    }
+
+    double WindowedHistogram::sum() const {
+        return window_sample().sample_sum;
+    }
+
+    double WindowedHistogram::quantile(double ratio) const {
+        auto hs = window_sample();
+        auto &buckets = hs.buckets;
+        const int64_t total = hs.sample_count;
+        if (total == 0) {
+            return 0;
+        }
+        ratio = std::min(std::max(ratio, 0.0), 1.0);
+        const double rank = ratio * static_cast<double>(total);
+        int64_t cumulative = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            auto &b = buckets[i];
+            if (b.value == 0 || static_cast<double>(cumulative + b.value) < rank) {
+                cumulative += b.value;
+                continue;
+            }
+            if (b.upper_bound == std::numeric_limits<double>::max()) {
+                // Nothing is known above the catch-all bucket.
+                return b.lower_bound;
+            }
+            // The first bucket starts from 0 unless it covers negatives.
+            double lower = b.lower_bound;
+            if (i == 0 && lower == std::numeric_limits<double>::min()) {
+                lower = std::min(0.0, b.upper_bound);
+            }
+            return lower + (b.upper_bound - lower) * (rank - static_cast<double>(cumulative)) /
+                           static_cast<double>(b.value);
+        }
+        return buckets.back().lower_bound;
+    }
+
+    void WindowedHistogram::describe(std::ostream &os, bool) const {
+        auto hs = window_sample();
+        os << '{';
+        for (auto &b: hs.buckets) {
+            if (b.upper_bound == std::numeric_limits<double>::max()) {
+                os << "+Inf";
+            } else {
+                os << b.upper_bound;
+            }
+            os << '=' << b.value << ' ';
+        }
+        os << "sum=" << hs.sample_sum << " count=" << hs.sample_count << '}';
+    }
+
+    MetricSample WindowedHistogram::get_metric(const turbo::Time &stamp) const {
+        return {type(), window_sample(), stamp};
+    }
+
+}  // namespace tally
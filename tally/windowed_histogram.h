@@ -0,0 +1,97 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <tally/histogram.h>
+#include <tally/impl/sampler.h>
+
+namespace tally {
+
+    // Distribution of the values recorded in the recent `window_size'
+    // seconds, e.g. latencies of the last minute for local dashboards and
+    // SLO burn rates. Records go to a cumulative Histogram. Every second a
+    // sampler moves the per-bucket deltas into a ring of `window_size'
+    // ticks and adds them to a running total, so reading the window costs
+    // one copy instead of summing the ring.
+    //
+    // Besides the histogram, the window takes
+    //   (window_size + 2) * (buckets.size() + 2) * 8 bytes
+    // for counts of the buckets and the catch-all bucket plus the sum, of
+    // each tick, the running total and the last cumulative values, e.g.
+    // about 11KB for 20 buckets over 60 seconds.
+    //
+    // The window is exposed as a window variable, which is described but
+    // not reported as a metric since its buckets go down.
+    class WindowedHistogram : public Variable {
+    public:
+        // A non-positive `window_size' takes FLAGS_tally_dump_interval.
+        explicit WindowedHistogram(const Buckets &buckets, time_t window_size = -1) noexcept;
+
+        WindowedHistogram(const Buckets &buckets, time_t window_size, std::string_view name, std::string_view help,
+                          turbo::Nonnull<Scope *> scope = ScopeInstance::instance()->get_default().get()) noexcept;
+
+        ~WindowedHistogram() override;
+
+        WindowedHistogram(const WindowedHistogram &) = delete;
+        WindowedHistogram &operator=(const WindowedHistogram &) = delete;
+
+        void record(double value) noexcept { histogram_.record(value); }
+
+        void record(double value, const turbo::flat_hash_map<std::string, std::string> &exemplar_labels) noexcept {
+            histogram_.record(value, exemplar_labels);
+        }
+
+        TimeRecorder record_timer(TimeUnit unit = TimeUnit::kMicroseconds) noexcept {
+            return histogram_.record_timer(unit);
+        }
+
+        // In seconds.
+        time_t window_size() const { return window_size_; }
+
+        // Buckets with the counts of the window.
+        std::vector<HistogramBucket> get_value() const;
+
+        // Number and sum of values recorded within the window.
+        int64_t count() const;
+
+        double sum() const;
+
+        // The `ratio'-quantile of the window, interpolated linearly inside
+        // the bucket it falls in like histogram_quantile() of prometheus.
+        // Returns 0 if the window is empty.
+        double quantile(double ratio) const;
+
+        // The cumulative histogram being recorded, which can be exposed as
+        // a metric on its own.
+        Histogram &histogram() { return histogram_; }
+
+        void describe(std::ostream &os, bool quote_string) const override;
+
+        void get_value(std::any *value) const override { *value = get_value(); }
+
+        MetricSample get_metric(const turbo::Time &stamp) const override;
+
+    private:
+        class WindowSampler;
+
+        HistogramSample window_sample() const;
+
+        Histogram histogram_;
+        time_t window_size_;
+        WindowSampler *sampler_;
+    };
+
+}  // namespace tally
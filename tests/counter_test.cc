@@ -14,6 +14,7 @@
 //
 
 #include <gtest/gtest.h>
+#include <thread>
 
 #include "mock_stats_reporter.h"
 #include <tally/tally.h>
@@ -63,3 +64,85 @@ TEST(CounterImplTest, ValueIsReset) {
     counter.increment(2);
     reporter->report_variable(&counter, now);
 }
+
+TEST(CounterImplTest, PerCpu) {
+    tally::PerCpuCounter<int64_t> counter;
+    tally::PerCpuMaxerGauge<int64_t> maxer;
+    // Short-lived threads leave nothing behind.
+    for (int round = 0; round < 10; ++round) {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&, i] {
+                for (int j = 0; j < 1000; ++j) {
+                    counter.increment();
+                    maxer.update(round * 100 + i);
+                }
+            });
+        }
+        for (auto &t: threads) {
+            t.join();
+        }
+    }
+    EXPECT_EQ(80000, counter.get_value());
+    EXPECT_EQ(907, maxer.get_value());
+    EXPECT_EQ(80000, counter.reset());
+    EXPECT_EQ(0, counter.get_value());
+
+    tally::Window<tally::PerCpuCounter<int64_t>> window(&counter, 2);
+    counter.increment(3);
+    EXPECT_EQ(3, counter.get_value());
+}
+
+TEST(CounterImplTest, LocalBatch) {
+    tally::Counter<int64_t> counter;
+    tally::MaxerGauge<int64_t> maxer;
+    tally::PerCpuCounter<int64_t> per_cpu;
+    tally::Histogram histogram(tally::Buckets::linear_values(1, 1, 3));
+    {
+        tally::LocalBatch batch;
+        auto &c = batch.get(&counter);
+        auto &m = batch.get(&maxer);
+        auto &p = batch.get(&per_cpu);
+        auto &h = batch.get(&histogram);
+        for (int i = 0; i < 100; ++i) {
+            c << 2;
+            m << i;
+            p << 1;
+            h.record(i % 4 + 0.5);
+        }
+        // Nothing is visible before flushing.
+        EXPECT_EQ(0, counter.get_value());
+        EXPECT_EQ(0, histogram.sample_count());
+        batch.flush();
+        EXPECT_EQ(200, counter.get_value());
+        EXPECT_EQ(99, maxer.get_value());
+        EXPECT_EQ(100, per_cpu.get_value());
+        EXPECT_EQ(100, histogram.sample_count());
+        EXPECT_DOUBLE_EQ(200, histogram.sample_sum());
+        c << 5;
+        h.record(0.5);
+    }
+    EXPECT_EQ(205, counter.get_value());
+    EXPECT_EQ(101, histogram.sample_count());
+    auto buckets = histogram.get_value();
+    ASSERT_EQ(4u, buckets.size());
+    EXPECT_EQ(26, buckets[0].value);
+    EXPECT_EQ(25, buckets[3].value);
+
+    // Buckets set after the slot was made.
+    tally::Histogram late;
+    {
+        tally::LocalBatch batch;
+        auto &h = batch.get(&late);
+        h.record(0.5);
+        late.set_buckets(tally::Buckets::linear_values(1, 1, 3));
+        h.record(0.5);
+        h.record(7);
+    }
+    EXPECT_EQ(2, late.sample_count());
+    buckets = late.get_value();
+    ASSERT_EQ(4u, buckets.size());
+    EXPECT_EQ(1, buckets[0].value);
+    EXPECT_EQ(1, buckets[3].value);
+}
+
@@ -0,0 +1,49 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+#include <tally/tally.h>
+
+TEST(DistinctCounterTest, window) {
+    tally::DistinctCounter<> users(60, "distinct_test", "users");
+    tally::DistinctCounter<10> small(2);
+    ASSERT_EQ(0, users.get_value());
+    // Two threads adding overlapping keys.
+    std::thread th([&users] {
+        for (int i = 0; i < 60000; ++i) {
+            users << i;
+        }
+    });
+    for (int i = 40000; i < 100000; ++i) {
+        users << i;
+    }
+    th.join();
+    for (int i = 0; i < 100; ++i) {
+        small << std::to_string(i) << std::to_string(i);
+    }
+    usleep(1100000);
+    ASSERT_NEAR(100000, users.get_value(), 100000 * 3 * users.standard_error());
+    ASSERT_NEAR(100, small.get_value(), 3);
+    auto sample = users.get_metric(turbo::Time::current_time());
+    ASSERT_TRUE(sample.type.is_gauge());
+
+    // Keys of the previous tick stay in the window.
+    users << 1;
+    usleep(1000000);
+    ASSERT_NEAR(100000, users.get_value(), 100000 * 3 * users.standard_error());
+}
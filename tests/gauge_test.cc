@@ -14,8 +14,11 @@
 //
 
 #include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
 
 #include "mock_stats_reporter.h"
+#include "prometheus_text.h"
 #include <tally/tally.h>
 
 
@@ -184,4 +187,68 @@ TEST(RecorderTest, perf) {
     KLOG(INFO) << "Recorder takes " << totol_time / (OPS_PER_THREAD * TURBO_ARRAYSIZE(threads))
               << "ns per sample with " << TURBO_ARRAYSIZE(threads)
               << " threads";
-}
\ No newline at end of file
+}
+TEST(GaugeImplTest, UpDown) {
+    tally::UpDownGauge<int64_t> inflight;
+    ASSERT_TRUE(inflight.type().is_gauge());
+    inflight.increment();
+    // A thread which starts requests and exits before they finish.
+    std::thread th([&inflight] {
+        inflight.increment(3);
+    });
+    th.join();
+    ASSERT_EQ(4, inflight.get_value());
+    inflight.decrement(2);
+    inflight.decrement();
+    ASSERT_EQ(1, inflight.get_value());
+    auto sample = inflight.get_metric(turbo::Time::current_time());
+    ASSERT_TRUE(sample.type.is_gauge());
+    ASSERT_EQ(1.0, std::get<double>(sample.value));
+
+    tally::PerCpuUpDownGauge<int64_t> depth;
+    depth.increment(5);
+    depth.decrement(6);
+    ASSERT_EQ(-1, depth.get_value());
+}
+
+TEST(GaugeImplTest, GaugeGroup) {
+    int calls = 0;
+    tally::GaugeGroup group(2, [&calls](double *values) {
+        ++calls;
+        values[0] = calls;
+        values[1] = calls * 10;
+    });
+    tally::GroupGauge<double> first(&group, 0, "group_first", "first");
+    tally::GroupGauge<int64_t> second(&group, 1, "group_second", "second");
+    // One call per scrape.
+    auto stamp = turbo::Time::from_milliseconds(1000);
+    ASSERT_EQ(1.0, std::get<double>(first.get_metric(stamp).value));
+    ASSERT_EQ(10.0, std::get<double>(second.get_metric(stamp).value));
+    ASSERT_EQ(1, calls);
+    stamp = turbo::Time::from_milliseconds(2000);
+    ASSERT_EQ(20.0, std::get<double>(second.get_metric(stamp).value));
+    ASSERT_EQ(2.0, std::get<double>(first.get_metric(stamp).value));
+    ASSERT_EQ(2, calls);
+    // Reads without a stamp reuse the last second.
+    ASSERT_EQ(2.0, first.get_value());
+    ASSERT_EQ(20, second.get_value());
+    std::ostringstream oss;
+    second.describe(oss, false);
+    ASSERT_EQ("20", oss.str());
+    ASSERT_EQ(2, calls);
+
+    calls = 0;
+    tally::MultiFuncGauge cache("cache_bytes", "cache memory", "state", {"used", "free"},
+                                [&calls](double *values) {
+                                    ++calls;
+                                    values[0] = 1024;
+                                    values[1] = 3072;
+                                });
+    PrometheusText text;
+    text.report(&cache);
+    auto &name = cache.full_name();
+    ASSERT_TRUE(text.has_type(name, "gauge"));
+    ASSERT_TRUE(text.contains(name + "{state=\"used\"} 1024"));
+    ASSERT_TRUE(text.contains(name + "{state=\"free\"} 3072"));
+    ASSERT_EQ(1, calls);
+}
@@ -14,6 +14,8 @@
 //
 
 #include <chrono>
+#include <sstream>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -36,6 +38,117 @@ TEST(HistogramImplTest, RecordValueOnce) {
     histogram.record(value);
     reporter->report_variable(&histogram, now);
 }
+TEST(HistogramImplTest, RecordExemplar) {
+    auto buckets = tally::Buckets::linear_values(0.0, 1.0, 10);
+    tally::Histogram histogram(buckets);
+    histogram.record(0.5);
+    auto sample = std::get<tally::HistogramSample>(histogram.get_metric(turbo::Time::current_time()).value);
+    ASSERT_TRUE(sample.exemplars.empty());
+
+    histogram.record(1.5, {{"trace_id", "abc"}});
+    std::thread th([&histogram] {
+        histogram.record(5.5, {{"trace_id", "def"}});
+    });
+    th.join();
+    histogram.record(1.25, {{"trace_id", "ghi"}});
+    // labels longer than 128 characters are dropped
+    histogram.record(1.75, {{"trace_id", std::string(200, 'x')}});
+
+    sample = std::get<tally::HistogramSample>(histogram.get_metric(turbo::Time::current_time()).value);
+    ASSERT_EQ(sample.buckets.size(), sample.exemplars.size());
+    ASSERT_EQ(5, sample.sample_count);
+    size_t found = 0;
+    for (size_t i = 0; i < sample.buckets.size(); ++i) {
+        auto &b = sample.buckets[i];
+        auto &e = sample.exemplars[i];
+        if (b.lower_bound <= 1.25 && 1.25 < b.upper_bound) {
+            ASSERT_TRUE(e.has_value());
+            ASSERT_EQ(1.25, e->value);
+            ASSERT_EQ("ghi", e->labels.at("trace_id"));
+            ++found;
+        } else if (b.lower_bound <= 5.5 && 5.5 < b.upper_bound) {
+            // committed by the exited thread
+            ASSERT_TRUE(e.has_value());
+            ASSERT_EQ(5.5, e->value);
+            ASSERT_EQ("def", e->labels.at("trace_id"));
+            ++found;
+        } else {
+            ASSERT_FALSE(e.has_value());
+        }
+    }
+    ASSERT_EQ(2UL, found);
+}
+
+TEST(HistogramImplTest, OpenMetricsExposition) {
+    auto scope = tally::ScopeBuilder().prefix("om").build();
+    auto buckets = tally::Buckets::linear_values(1.0, 1.0, 2);
+    tally::Histogram histogram(buckets, "latency_seconds", "request latency", scope.get());
+    histogram.set_unit("seconds");
+    histogram.record(0.5);
+    histogram.record(1.5, {{"trace_id", "abc"}});
+    histogram.record(9);
+
+    std::stringstream ss;
+    tally::PrometheusStatsReporter reporter(ss, true);
+    reporter.report_variable(&histogram, turbo::Time::current_time());
+    reporter.flush();
+    auto text = ss.str();
+    auto name = histogram.full_name();
+    EXPECT_NE(std::string::npos, text.find("# TYPE " + name + " histogram\n")) << text;
+    EXPECT_NE(std::string::npos, text.find("# UNIT " + name + " seconds\n")) << text;
+    EXPECT_NE(std::string::npos, text.find(name + "_bucket{le=\"1\"} 1\n")) << text;
+    EXPECT_NE(std::string::npos, text.find(name + "_bucket{le=\"2\"} 2 # {trace_id=\"abc\"} 1.5 ")) << text;
+    EXPECT_NE(std::string::npos, text.find(name + "_bucket{le=\"+Inf\"} 3\n")) << text;
+    EXPECT_NE(std::string::npos, text.find(name + "_count 3\n")) << text;
+    EXPECT_NE(std::string::npos, text.find(name + "_created ")) << text;
+    EXPECT_EQ(text.size() - 6, text.rfind("# EOF\n")) << text;
+
+    tally::Counter<int64_t> counter("requests_total", "requests", scope.get());
+    counter.increment(3);
+    std::stringstream cs;
+    tally::PrometheusStatsReporter counter_reporter(cs, true);
+    counter_reporter.report_variable(&counter, turbo::Time());
+    auto family = counter.full_name().substr(0, counter.full_name().size() - 6);
+    EXPECT_NE(std::string::npos, cs.str().find("# TYPE " + family + " counter\n")) << cs.str();
+    EXPECT_NE(std::string::npos, cs.str().find(family + "_total 3\n")) << cs.str();
+    EXPECT_NE(std::string::npos, cs.str().find(family + "_created ")) << cs.str();
+}
+
+TEST(HistogramImplTest, WindowedHistogram) {
+    auto buckets = tally::Buckets::linear_values(1.0, 1.0, 3);
+    tally::WindowedHistogram histogram(buckets, 2);
+    ASSERT_EQ(0, histogram.count());
+    ASSERT_EQ(0, histogram.quantile(0.5));
+    for (int i = 0; i < 10; ++i) {
+        histogram.record(1.5);
+    }
+    histogram.record(0.5);
+    histogram.record(10);
+    // Wait for a tick.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+    ASSERT_EQ(12, histogram.count());
+    ASSERT_DOUBLE_EQ(25.5, histogram.sum());
+    auto window = histogram.get_value();
+    ASSERT_EQ(4UL, window.size());
+    ASSERT_EQ(1, window[0].value);
+    ASSERT_EQ(10, window[1].value);
+    ASSERT_EQ(0, window[2].value);
+    ASSERT_EQ(1, window[3].value);
+    // The first bucket is interpolated from 0.
+    ASSERT_DOUBLE_EQ(0.6, histogram.quantile(0.05));
+    ASSERT_DOUBLE_EQ(1.5, histogram.quantile(0.5));
+    ASSERT_DOUBLE_EQ(3, histogram.quantile(1));
+    std::stringstream ss;
+    histogram.describe(ss, false);
+    ASSERT_EQ("{1=1 2=10 3=0 +Inf=1 sum=25.5 count=12}", ss.str());
+
+    // Both ticks in the window are empty after another two.
+    std::this_thread::sleep_for(std::chrono::milliseconds(2200));
+    ASSERT_EQ(0, histogram.count());
+    ASSERT_EQ(0, histogram.sum());
+    ASSERT_EQ(12, histogram.histogram().sample_count());
+}
+
 /*
 TEST(HistogramImplTest, RecordDurationOnce) {
     std::string name("foo");
@@ -216,6 +216,22 @@ namespace {
         KLOG(INFO) << r1._latency;
     }
 
+TEST_F(LockTimerTest, cycle_timer) {
+    tally::CycleTimer timer;
+    timer.start();
+    usleep(20000);
+    timer.stop();
+    ASSERT_GE(timer.u_elapsed(), 15000);
+    ASSERT_LT(timer.u_elapsed(), 1000000);
+    ASSERT_EQ(timer.n_elapsed(), turbo::Duration::to_nanoseconds(timer.elapsed()));
+    // The calibration may finish in between otherwise.
+    const bool tsc = tally::CycleClock::tsc_enabled();
+    const int64_t t0 = tally::CycleClock::now(tsc);
+    const int64_t t1 = tally::CycleClock::now_ordered(tsc);
+    ASSERT_LE(t0, t1);
+    KLOG(INFO) << "tsc_enabled=" << tsc;
+}
+
 TEST_F(LockTimerTest, overhead) {
     LatencyRecorder r0;
     MutexWithLatencyRecorder<DummyMutex> m0(r0);
@@ -0,0 +1,50 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <unistd.h>
+#include <sstream>
+#include <gtest/gtest.h>
+#include <tally/tally.h>
+#include "prometheus_text.h"
+
+TEST(MeterTest, rates) {
+    tally::Meter meter("meter_test", "events");
+    ASSERT_EQ(3UL, meter.num_children());
+    ASSERT_EQ(0, meter.rate(0));
+    meter.mark(1000);
+    usleep(1100000);
+    ASSERT_EQ(1000, meter.count());
+    auto rates = meter.rates();
+    ASSERT_LT(0, rates[0]);
+    ASSERT_LT(0, rates[2]);
+    usleep(1000000);
+    // Idle ticks take the 1 minute rate down faster.
+    rates = meter.rates();
+    ASSERT_LT(0, rates[0]);
+    ASSERT_LT(rates[0], rates[2]);
+
+    PrometheusText text;
+    text.report(&meter);
+    auto &name = meter.full_name();
+    ASSERT_TRUE(text.has_type(name, "gauge"));
+    ASSERT_TRUE(text.contains(name + "{window=\"1m\"} "));
+    ASSERT_TRUE(text.contains(name + "{window=\"5m\"} "));
+    ASSERT_TRUE(text.contains(name + "{window=\"15m\"} "));
+
+    tally::Meter custom({90, 0});
+    std::stringstream desc;
+    custom.describe(desc, false);
+    ASSERT_EQ("{90s=0 1s=0}", desc.str());
+}
@@ -15,6 +15,8 @@
 
 #include <tally/impl/percentile.h>
 #include <turbo/log/logging.h>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <fstream>
 
@@ -48,6 +50,70 @@ TEST_F(PercentileTest, add) {
     }
 }
 
+TEST_F(PercentileTest, interval_index) {
+    for (int64_t x : {-1L, 0L, 1L, 2L}) {
+        ASSERT_EQ(0u, tally::detail::get_interval_index(x));
+    }
+    for (size_t i = 1; i < tally::detail::NUM_INTERVALS; ++i) {
+        int64_t x = 1L << i;
+        ASSERT_EQ(i - 1, tally::detail::get_interval_index(x)) << x;
+        x = (1L << i) + 1;
+        ASSERT_EQ(i, tally::detail::get_interval_index(x)) << x;
+    }
+    // Larger latencies are in the last interval, taken as the largest.
+    int64_t x = std::numeric_limits<int64_t>::max();
+    ASSERT_EQ(tally::detail::NUM_INTERVALS - 1, tally::detail::get_interval_index(x));
+    ASSERT_EQ(tally::detail::MAX_LATENCY,
+              tally::detail::decode_sample(tally::detail::encode_sample(x, tally::detail::NUM_INTERVALS - 1),
+                                           tally::detail::NUM_INTERVALS - 1));
+    for (size_t i = 0; i < tally::detail::NUM_INTERVALS; ++i) {
+        // The largest latency of each interval fits in a sample.
+        const uint64_t largest = 2UL << i;
+        ASSERT_LE(largest >> tally::detail::interval_shift(i),
+                  std::numeric_limits<uint32_t>::max()) << i;
+    }
+    ASSERT_EQ(3u, tally::detail::encode_sample(3, 1));
+    ASSERT_EQ(int64_t(3) << 32,
+              tally::detail::decode_sample(tally::detail::encode_sample(int64_t(3) << 32, 33), 33));
+}
+
+TEST_F(PercentileTest, pending_intervals) {
+    tally::detail::IntervalQueue q;
+    tally::detail::IntervalQueue::interval_type interval;
+    while (!interval.full()) {
+        ASSERT_TRUE(interval.add32(interval.sample_count() + 1));
+    }
+    for (size_t i = 0; i < tally::detail::IntervalQueue::MAX_PENDING; ++i) {
+        ASSERT_TRUE(q.push(4, interval));
+    }
+    ASSERT_FALSE(q.push(4, interval));
+    tally::detail::GlobalPercentileSamples g;
+    q.merge_into(&g);
+    ASSERT_TRUE(q.empty());
+    ASSERT_EQ(tally::detail::IntervalQueue::MAX_PENDING * interval.added_count(), g._num_added);
+    ASSERT_TRUE(q.push(4, interval));
+
+    // Intervals filled up by writers are merged by readers.
+    tally::detail::Percentile p;
+    const int N = 100000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&p] {
+            for (int i = 0; i < N; ++i) {
+                p << (i % 1000 + 1);
+            }
+        });
+    }
+    for (auto &th: threads) {
+        th.join();
+    }
+    tally::detail::GlobalPercentileSamples b = p.reset();
+    ASSERT_EQ(4UL * N, b._num_added);
+    ASSERT_TRUE(p._pending.empty());
+    ASSERT_GT(b.get_number(0.5), 400);
+    ASSERT_LT(b.get_number(0.5), 600);
+}
+
 TEST_F(PercentileTest, merge1) {
     // Merge 2 PercentileIntervals b1 and b2. b2 has double SAMPLE_SIZE
     // and num_added. Remaining samples of b1 and b2 in merged result should
@@ -0,0 +1,52 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tally/tally.h>
+
+// Variables reported by a PrometheusStatsReporter into a string, for
+// checking what they expose.
+class PrometheusText {
+public:
+    explicit PrometheusText(bool open_metrics = false) : _reporter(_ss, open_metrics) {}
+
+    PrometheusText &report(const tally::Variable *var,
+                           const turbo::Time &stamp = turbo::Time::from_milliseconds(0)) {
+        _reporter.report_variable(var, stamp);
+        return *this;
+    }
+
+    const tally::PrometheusStatsReporter &reporter() const { return _reporter; }
+
+    std::string str() const { return _ss.str(); }
+
+    bool contains(const std::string &s) const { return str().find(s) != std::string::npos; }
+
+    // True if the family `name' is declared once, as `type'.
+    bool has_type(const std::string &name, std::string_view type) const {
+        const auto out = str();
+        const auto line = "# TYPE " + name + " " + std::string(type) + "\n";
+        const auto pos = out.find(line);
+        return pos != std::string::npos && out.find(line, pos + 1) == std::string::npos;
+    }
+
+private:
+    std::stringstream _ss;
+    tally::PrometheusStatsReporter _reporter;
+};
@@ -49,7 +49,7 @@ namespace {
         for (int i = 0; i < 5; ++i) {
             recorder1 << std::numeric_limits<int64_t>::max();
         }
-        ASSERT_EQ(std::numeric_limits<int>::max(), recorder1.average());
+        ASSERT_EQ(std::numeric_limits<int64_t>::max() / 5, recorder1.average());
 
         tally::AverageGauge recorder2;
         ASSERT_TRUE(recorder2.valid());
@@ -57,7 +57,7 @@ namespace {
         for (int i = 0; i < 5; ++i) {
             recorder2 << std::numeric_limits<int64_t>::max();
         }
-        ASSERT_EQ(std::numeric_limits<int>::max(), recorder2.average());
+        ASSERT_EQ(std::numeric_limits<int64_t>::max() / 5, recorder2.average());
 
         tally::AverageGauge recorder3;
         ASSERT_TRUE(recorder3.valid());
@@ -66,7 +66,7 @@ namespace {
         for (int i = 0; i < 5; ++i) {
             recorder3 << std::numeric_limits<int64_t>::max();
         }
-        ASSERT_EQ(std::numeric_limits<int>::max(), recorder3.average());
+        ASSERT_EQ(std::numeric_limits<int64_t>::max() / 5, recorder3.average());
 
         tally::LatencyRecorder latency1;
         rs = latency1.expose("latency1", "help", scope.get());
@@ -84,7 +84,7 @@ namespace {
         for (int i = 0; i < 5; ++i) {
             recorder1 << std::numeric_limits<int64_t>::min();
         }
-        ASSERT_EQ(std::numeric_limits<int>::min(), recorder1.average());
+        ASSERT_EQ(std::numeric_limits<int64_t>::min() / 5, recorder1.average());
 
         tally::AverageGauge recorder2;
         ASSERT_TRUE(recorder2.valid());
@@ -92,7 +92,7 @@ namespace {
         for (int i = 0; i < 5; ++i) {
             recorder2 << std::numeric_limits<int64_t>::min();
         }
-        ASSERT_EQ(std::numeric_limits<int>::min(), recorder2.average());
+        ASSERT_EQ(std::numeric_limits<int64_t>::min() / 5, recorder2.average());
 
         tally::AverageGauge recorder3;
         ASSERT_TRUE(recorder3.valid());
@@ -101,7 +101,7 @@ namespace {
         for (int i = 0; i < 5; ++i) {
             recorder3 << std::numeric_limits<int64_t>::min();
         }
-        ASSERT_EQ(std::numeric_limits<int>::min(), recorder3.average());
+        ASSERT_EQ(std::numeric_limits<int64_t>::min() / 5, recorder3.average());
 
         tally::LatencyRecorder latency1;
         rs = latency1.expose("latency1", "help", scope.get());
@@ -113,6 +113,40 @@ namespace {
     }
 
 
+    TEST(RecorderTest, wide_samples) {
+        tally::AverageGauge recorder;
+        const int64_t big = 1L << 40;
+        recorder << big << 1 << -big << 3;
+        tally::Stat s = recorder.get_value();
+        ASSERT_EQ(4, s.sum);
+        ASSERT_EQ(4, s.num);
+        recorder << big << big;
+        ASSERT_EQ(big * 2 + 4, recorder.get_value().sum);
+        ASSERT_EQ(big * 2 + 4, recorder.reset().sum);
+        ASSERT_EQ(0, recorder.get_value().num);
+
+        tally::detail::Percentile p;
+        const int64_t wide = 1L << 34;
+        for (int64_t i = 1; i <= 100; ++i) {
+            p << i * wide;
+        }
+        tally::detail::GlobalPercentileSamples b = p.reset();
+        const int64_t p50 = b.get_number(0.5);
+        // Samples above 2^31 keep 31 leading bits.
+        ASSERT_LE(p50, 50 * wide);
+        ASSERT_GT(p50, 50 * wide - (50 * wide >> 30));
+        ASSERT_EQ(100 * wide, b.get_number(1));
+        p << std::numeric_limits<int64_t>::max();
+        ASSERT_EQ(tally::detail::MAX_LATENCY, p.reset().get_number(1));
+
+        tally::LatencyRecorder rec;
+        rec.set_time_unit(tally::TimeUnit::kNanoseconds);
+        rec.record(turbo::Duration::nanoseconds(250));
+        rec.record(turbo::Duration::seconds(10));
+        ASSERT_EQ(2, rec.count());
+        ASSERT_EQ(10000000250L, rec._latency.get_value().sum);
+    }
+
     TEST(RecorderTest, latency_recorder_qps_accuracy) {
         tally::LatencyRecorder lr1(2); // set windows size to 2s
         tally::LatencyRecorder lr2(2);
@@ -154,4 +188,100 @@ namespace {
         ASSERT_GT(0.1, read(lr4, 1 / 3.0, 3));
     }
 
+    TEST(RecorderTest, cached_percentiles) {
+        tally::LatencyRecorder lr(10);
+        for (int i = 1; i <= 1000; ++i) {
+            lr << i;
+        }
+        usleep(2500000); // wait sampler to sample the latencies twice
+        // Percentiles of the same tick are combined once.
+        auto cb1 = lr.combined_percentile_samples();
+        auto cb2 = lr.combined_percentile_samples();
+        if (lr._latency_percentile_window.latest_sample_time_us() ==
+            lr._combined_time_us) {
+            ASSERT_EQ(cb1.get(), cb2.get());
+        }
+        // The combination is not kept once readers are done.
+        cb1.reset();
+        cb2.reset();
+        ASSERT_TRUE(lr._combined.expired());
+        auto latencies = lr.latency_percentiles();
+        ASSERT_EQ(lr.latency_percentile(0.999), latencies[3]);
+        // Samples are reserved per interval, 99.9% is in the last one.
+        ASSERT_GE(latencies[3], 512);
+        ASSERT_LE(latencies[0], latencies[1]);
+        ASSERT_LE(latencies[1], latencies[2]);
+        ASSERT_LE(latencies[2], latencies[3]);
+        std::ostringstream os;
+        lr._latency_cdf.describe(os, false);
+        ASSERT_NE(std::string::npos, os.str().find("[101,"));
+    }
+
+    TEST(RecorderTest, fast_latency_recorder) {
+        tally::LatencyRecorder lr("fast_ref", "");
+        tally::FastLatencyRecorder flr("fast_rec", "");
+        ASSERT_EQ("fast_rec_latency", flr.latency_name());
+        ASSERT_EQ("fast_rec_max_latency", flr.max_latency_name());
+        ASSERT_EQ("fast_rec_count", flr.count_name());
+        ASSERT_EQ("fast_rec_qps", flr.qps_name());
+        ASSERT_EQ("fast_rec_latency_percentiles", flr.latency_percentiles_name());
+        ASSERT_EQ("fast_rec_latency_cdf", flr.latency_cdf_name());
+        std::vector<std::string> names;
+        tally::Variable::list_exposed(&names);
+        size_t fast_names = 0;
+        size_t ref_names = 0;
+        for (auto &name: names) {
+            fast_names += name.find("fast_rec_") == 0;
+            ref_names += name.find("fast_ref_") == 0;
+        }
+        ASSERT_EQ(ref_names, fast_names);
+
+        for (int i = 1; i <= 1000; ++i) {
+            lr << i;
+            flr << i;
+        }
+        flr << -1;  // dropped
+        usleep(2500000); // wait sampler to sample the latencies twice
+        ASSERT_EQ(1000, flr.count());
+        ASSERT_EQ(lr.latency(), flr.latency());
+        ASSERT_EQ(1000, flr.max_latency());
+        ASSERT_EQ(lr.max_latency(), flr.max_latency());
+        ASSERT_LT(0, flr.qps());
+        auto latencies = flr.latency_percentiles();
+        ASSERT_EQ(flr.latency_percentile(0.999), latencies[3]);
+        ASSERT_GE(latencies[3], 512);
+        ASSERT_LE(latencies[0], latencies[1]);
+        ASSERT_LE(latencies[1], latencies[2]);
+        ASSERT_LE(latencies[2], latencies[3]);
+        // Only the percentiles are kept, the combined samples are not.
+        ASSERT_TRUE(flr._combined.expired());
+        ASSERT_EQ(latencies[3], flr.snapshot()->percentiles[3].second);
+        ASSERT_EQ(std::to_string(flr.max_latency()),
+                  tally::Variable::describe_exposed(flr._max_latency.full_name()));
+        ASSERT_EQ("1000", tally::Variable::describe_exposed(flr._count.full_name()));
+        ASSERT_NE(std::string::npos,
+                  tally::Variable::describe_exposed(flr._latency_cdf.full_name()).find("[101,"));
+        const std::string count_name = flr._count.full_name();
+        flr.hide();
+        ASSERT_EQ("", tally::Variable::describe_exposed(count_name));
+    }
+
+    TEST(RecorderTest, fast_latency_recorder_summary) {
+        tally::FastLatencyRecorder flr("fast_summary", "", tally::ScopeInstance::instance()->get_default().get(),
+                                       10, {0.9, 0.5});
+        ASSERT_FALSE(flr.latency_summary_name().empty());
+        ASSERT_TRUE(flr._latency_p1.name().empty());
+        for (int i = 1; i <= 10; ++i) {
+            flr << i;
+        }
+        usleep(1500000); // count and sum are taken by the sampler
+        auto s = flr.summary();
+        ASSERT_EQ(2UL, s.quantiles.size());
+        ASSERT_EQ(0.5, s.quantiles[0].first);
+        ASSERT_EQ(0.9, s.quantiles[1].first);
+        ASSERT_EQ(55, s.sample_sum);
+        ASSERT_EQ(10, s.sample_count);
+        ASSERT_TRUE(flr._latency_summary.get_metric(turbo::Time::current_time()).type.is_summary());
+    }
+
 } // namespace
@@ -14,6 +14,7 @@
 //
 
 #include <limits>                           //std::numeric_limits
+#include <thread>
 
 #include <tally/tally.h>
 #include <gtest/gtest.h>
@@ -256,6 +257,96 @@ namespace {
         ASSERT_EQ(9, adder.get_value().x);
     }
 
+    struct Pair {
+        int64_t x;
+        int64_t y;
+
+        Pair() : x(0), y(0) {}
+
+        Pair(int64_t x2, int64_t y2) : x(x2), y(y2) {}
+
+        void operator+=(const Pair &rhs) {
+            x += rhs.x;
+            y += rhs.y;
+        }
+    };
+
+    std::ostream &operator<<(std::ostream &os, const Pair &p) {
+        return os << "Pair{" << p.x << ' ' << p.y << "}";
+    }
+
+    TEST_F(ReducerTest, seqlock_element) {
+        ASSERT_GE(sizeof(Pair) + 8, sizeof(tally::detail::ElementContainer<Pair>));
+        tally::AdderStatus<Pair> adder;
+        std::atomic<bool> stop{false};
+        const int64_t N = 200000;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&] {
+                for (int64_t j = 0; j < N; ++j) {
+                    adder << Pair(1, 2);
+                }
+            });
+        }
+        // Readers never see an element in the middle of a write, and
+        // resetting loses no value.
+        int64_t total = 0;
+        std::thread reader([&] {
+            while (!stop.load()) {
+                const Pair v = adder.get_value();
+                ASSERT_EQ(v.x * 2, v.y);
+                const Pair r = adder.reset();
+                ASSERT_EQ(r.x * 2, r.y);
+                total += r.x;
+            }
+        });
+        for (auto &t: threads) {
+            t.join();
+        }
+        stop = true;
+        reader.join();
+        total += adder.reset().x;
+        ASSERT_EQ(4 * N, total);
+    }
+
+    TEST_F(ReducerTest, thread_churn) {
+        tally::Counter<int64_t> counter;
+        tally::AdderStatus<Pair> adder;
+        std::atomic<bool> stop{false};
+        // Threads come and go while values are read and reset.
+        int64_t total = 0;
+        int64_t pair_total = 0;
+        std::thread reader([&] {
+            while (!stop.load()) {
+                total += counter.reset();
+                const Pair p = adder.get_value();
+                ASSERT_EQ(p.x * 2, p.y);
+                pair_total += adder.reset().x;
+            }
+        });
+        for (int round = 0; round < 200; ++round) {
+            std::vector<std::thread> threads;
+            for (int i = 0; i < 4; ++i) {
+                threads.emplace_back([&] {
+                    for (int j = 0; j < 100; ++j) {
+                        counter << 1;
+                        adder << Pair(1, 2);
+                    }
+                });
+            }
+            for (auto &t: threads) {
+                t.join();
+            }
+        }
+        stop = true;
+        reader.join();
+        total += counter.reset();
+        pair_total += adder.reset().x;
+        ASSERT_EQ(200 * 4 * 100, total);
+        ASSERT_EQ(200 * 4 * 100, pair_total);
+        ASSERT_EQ(0, counter.get_value());
+    }
+
     bool g_stop = false;
     struct StringAppenderResult {
         int count;
@@ -0,0 +1,479 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <tally/tally.h>
+#include "prometheus_text.h"
+
+namespace {
+
+    // Just enough protobuf decoding to verify the encoder.
+    struct Field {
+        uint32_t number{0};
+        uint32_t wire{0};
+        uint64_t varint{0};
+        double fixed{0};
+        std::string bytes;
+    };
+
+    bool read_varint(std::string_view &in, uint64_t *v) {
+        *v = 0;
+        for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+            uint8_t b = static_cast<uint8_t>(in.front());
+            in.remove_prefix(1);
+            *v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Field> parse_message(std::string_view in) {
+        std::vector<Field> fields;
+        while (!in.empty()) {
+            uint64_t tag;
+            EXPECT_TRUE(read_varint(in, &tag));
+            Field f;
+            f.number = static_cast<uint32_t>(tag >> 3);
+            f.wire = static_cast<uint32_t>(tag & 7);
+            if (f.wire == 0) {
+                EXPECT_TRUE(read_varint(in, &f.varint));
+            } else if (f.wire == 1) {
+                EXPECT_GE(in.size(), 8UL);
+                memcpy(&f.fixed, in.data(), 8);
+                in.remove_prefix(8);
+            } else if (f.wire == 2) {
+                uint64_t len;
+                EXPECT_TRUE(read_varint(in, &len));
+                EXPECT_GE(in.size(), len);
+                f.bytes = std::string(in.substr(0, len));
+                in.remove_prefix(len);
+            } else {
+                ADD_FAILURE() << "unexpected wire type " << f.wire;
+                break;
+            }
+            fields.push_back(std::move(f));
+        }
+        return fields;
+    }
+
+    std::vector<const Field *> find_fields(const std::vector<Field> &fields, uint32_t number) {
+        std::vector<const Field *> result;
+        for (auto &f: fields) {
+            if (f.number == number) {
+                result.push_back(&f);
+            }
+        }
+        return result;
+    }
+
+    // name -> MetricFamily fields
+    std::map<std::string, std::vector<Field>> parse_families(std::string_view in) {
+        std::map<std::string, std::vector<Field>> families;
+        while (!in.empty()) {
+            uint64_t len;
+            EXPECT_TRUE(read_varint(in, &len));
+            auto fields = parse_message(in.substr(0, len));
+            in.remove_prefix(len);
+            auto name = find_fields(fields, 1);
+            EXPECT_EQ(1UL, name.size());
+            families[name[0]->bytes] = std::move(fields);
+        }
+        return families;
+    }
+
+    TEST(ReporterTest, negotiate_format) {
+        using tally::ExpositionFormat;
+        EXPECT_EQ(ExpositionFormat::kPrometheusText, tally::Reporter::negotiate_format(""));
+        EXPECT_EQ(ExpositionFormat::kPrometheusText, tally::Reporter::negotiate_format("text/plain;version=0.0.4"));
+        EXPECT_EQ(ExpositionFormat::kProtobufDelimited, tally::Reporter::negotiate_format(
+                "application/vnd.google.protobuf;proto=io.prometheus.client.MetricFamily;encoding=delimited;q=0.7,"
+                "text/plain;version=0.0.4;q=0.3,*/*;q=0.1"));
+        EXPECT_EQ(ExpositionFormat::kOpenMetricsText, tally::Reporter::negotiate_format(
+                "application/openmetrics-text; version=1.0.0,text/plain;version=0.0.4;q=0.5,*/*;q=0.1"));
+        // text encoding of protobuf is not supported
+        EXPECT_EQ(ExpositionFormat::kPrometheusText, tally::Reporter::negotiate_format(
+                "application/vnd.google.protobuf;proto=io.prometheus.client.MetricFamily;encoding=text,"
+                "text/plain;q=0.2"));
+        EXPECT_EQ("application/vnd.google.protobuf; proto=io.prometheus.client.MetricFamily; encoding=delimited",
+                  tally::Reporter::content_type(ExpositionFormat::kProtobufDelimited));
+    }
+
+    TEST(ReporterTest, protobuf_encoding) {
+        auto scope = tally::ScopeBuilder().prefix("pb").tags({{"host", "a"}}).build();
+        tally::Counter<int64_t> counter("requests", "request count", scope.get());
+        tally::Gauge<double> gauge("temperature", "", 0.0, scope.get());
+        tally::Histogram histogram(tally::Buckets::linear_values(1.0, 1.0, 2), "latency", "latency", scope.get());
+        counter.increment(300);
+        gauge.set_value(-2.5);
+        histogram.record(0.5);
+        histogram.record(1.5, {{"trace_id", "abc"}});
+        histogram.record(7);
+
+        std::stringstream ss;
+        tally::ProtobufStatsReporter reporter(ss);
+        auto now = turbo::Time::current_time();
+        reporter.report_variable(&counter, now);
+        reporter.report_variable(&gauge, now);
+        reporter.report_variable(&histogram, now);
+        auto families = parse_families(ss.str());
+        ASSERT_EQ(3UL, families.size());
+
+        auto &c = families[counter.full_name()];
+        ASSERT_EQ("request count", find_fields(c, 2)[0]->bytes);
+        ASSERT_EQ(0UL, find_fields(c, 3)[0]->varint);
+        auto metric = parse_message(find_fields(c, 4)[0]->bytes);
+        auto label = parse_message(find_fields(metric, 1)[0]->bytes);
+        ASSERT_EQ("host", find_fields(label, 1)[0]->bytes);
+        ASSERT_EQ("a", find_fields(label, 2)[0]->bytes);
+        auto value = parse_message(find_fields(metric, 3)[0]->bytes);
+        ASSERT_EQ(300, find_fields(value, 1)[0]->fixed);
+        ASSERT_EQ(1UL, find_fields(value, 3).size());
+
+        auto &g = families[gauge.full_name()];
+        ASSERT_TRUE(find_fields(g, 2).empty());
+        ASSERT_EQ(1UL, find_fields(g, 3)[0]->varint);
+        metric = parse_message(find_fields(g, 4)[0]->bytes);
+        value = parse_message(find_fields(metric, 2)[0]->bytes);
+        ASSERT_EQ(-2.5, find_fields(value, 1)[0]->fixed);
+
+        auto &h = families[histogram.full_name()];
+        ASSERT_EQ(4UL, find_fields(h, 3)[0]->varint);
+        metric = parse_message(find_fields(h, 4)[0]->bytes);
+        value = parse_message(find_fields(metric, 7)[0]->bytes);
+        ASSERT_EQ(3UL, find_fields(value, 1)[0]->varint);
+        ASSERT_EQ(9, find_fields(value, 2)[0]->fixed);
+        auto buckets = find_fields(value, 3);
+        ASSERT_EQ(3UL, buckets.size());
+        std::vector<uint64_t> counts;
+        for (auto b: buckets) {
+            counts.push_back(find_fields(parse_message(b->bytes), 1)[0]->varint);
+        }
+        ASSERT_EQ(std::vector<uint64_t>({1, 2, 3}), counts);
+        auto last = parse_message(buckets.back()->bytes);
+        ASSERT_TRUE(std::isinf(find_fields(last, 2)[0]->fixed));
+        auto second = parse_message(buckets[1]->bytes);
+        auto exemplar = parse_message(find_fields(second, 3)[0]->bytes);
+        ASSERT_EQ(1.5, find_fields(exemplar, 2)[0]->fixed);
+        label = parse_message(find_fields(exemplar, 1)[0]->bytes);
+        ASSERT_EQ("trace_id", find_fields(label, 1)[0]->bytes);
+        ASSERT_EQ("abc", find_fields(label, 2)[0]->bytes);
+    }
+
+    TEST(ReporterTest, protobuf_writer_varint) {
+        tally::ProtobufWriter w;
+        w.write_varint(0);
+        w.write_varint(127);
+        w.write_varint(300);
+        w.write_varint(std::numeric_limits<uint64_t>::max());
+        ASSERT_EQ(1UL + 1 + 2 + 10, w.size());
+        ASSERT_EQ(std::string("\x00\x7f\xac\x02", 4), w.buffer().substr(0, 4));
+        w.clear();
+        w.write_int64(1, -1);
+        ASSERT_EQ(11UL, w.size());
+    }
+
+    // Drop the trailing timestamp of samples.
+    std::vector<std::string> strip_timestamps(const std::string &text) {
+        std::vector<std::string> lines;
+        std::stringstream ss(text);
+        std::string line;
+        while (std::getline(ss, line)) {
+            if (!line.empty() && line[0] != '#') {
+                line = line.substr(0, line.rfind(' '));
+            }
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    TEST(ReporterTest, parallel_reporting) {
+        auto scope = tally::ScopeBuilder().prefix("parallel").build();
+        std::vector<std::unique_ptr<tally::Counter<int64_t>>> counters;
+        for (int i = 0; i < 200; ++i) {
+            counters.push_back(std::make_unique<tally::Counter<int64_t>>(
+                    "c" + std::to_string(i), "help", scope.get()));
+            counters.back()->increment(i);
+        }
+        tally::ReportOptions sequential;
+        sequential.parallelism(1);
+        for (int32_t n: {2, 5, 32, 100}) {
+            tally::ReportOptions parallel;
+            parallel.parallelism(n);
+            ASSERT_EQ(strip_timestamps(tally::Reporter::get_prometheus_reporting(&sequential)),
+                      strip_timestamps(tally::Reporter::get_prometheus_reporting(&parallel)));
+            auto om = tally::Reporter::get_openmetrics_reporting(&parallel);
+            ASSERT_EQ(strip_timestamps(tally::Reporter::get_openmetrics_reporting(&sequential)),
+                      strip_timestamps(om));
+            ASSERT_EQ(om.size() - 6, om.find("# EOF\n"));
+            auto pb = parse_families(tally::Reporter::get_protobuf_reporting(&parallel));
+            ASSERT_EQ(parse_families(tally::Reporter::get_protobuf_reporting(&sequential)).size(), pb.size());
+        }
+    }
+
+    TEST(ReporterTest, stream_reporting) {
+        auto scope = tally::ScopeBuilder().prefix("stream").build();
+        std::vector<std::unique_ptr<tally::Counter<int64_t>>> counters;
+        for (int i = 0; i < 100; ++i) {
+            counters.push_back(std::make_unique<tally::Counter<int64_t>>(
+                    "c" + std::to_string(i), "help", scope.get()));
+        }
+        for (int32_t parallelism: {1, 4}) {
+            tally::ReportOptions options;
+            options.parallelism(parallelism);
+            std::string streamed;
+            size_t chunks = 0;
+            ASSERT_TRUE(tally::Reporter::stream_reporting([&](std::string_view chunk) {
+                EXPECT_FALSE(chunk.empty());
+                EXPECT_LE(chunk.size(), 100UL);
+                streamed.append(chunk);
+                ++chunks;
+                return true;
+            }, tally::ExpositionFormat::kOpenMetricsText, &options, 100));
+            ASSERT_EQ((streamed.size() + 99) / 100, chunks);
+            ASSERT_EQ(strip_timestamps(tally::Reporter::get_openmetrics_reporting(&options)),
+                      strip_timestamps(streamed));
+        }
+
+        size_t chunks = 0;
+        ASSERT_FALSE(tally::Reporter::stream_reporting([&](std::string_view) {
+            ++chunks;
+            return false;
+        }, tally::ExpositionFormat::kPrometheusText, nullptr, 100));
+        ASSERT_EQ(1UL, chunks);
+    }
+
+    // A gauge remembering how many bytes were streamed out when it's read.
+    class StreamProbe : public tally::Variable {
+    public:
+        StreamProbe(const size_t *streamed, std::string_view name, tally::Scope *scope)
+                : Variable(tally::VariableAttr::gauge_attr()), _streamed(streamed) {
+            EXPECT_TRUE(expose(name, "", scope).ok());
+        }
+
+        ~StreamProbe() override { hide(); }
+
+        tally::MetricSample get_metric(const turbo::Time &stamp) const override {
+            streamed_at_read = *_streamed;
+            return {tally::VariableType::gauge_type(), 1.0, stamp};
+        }
+
+        mutable size_t streamed_at_read{0};
+
+    private:
+        const size_t *_streamed;
+    };
+
+    TEST(ReporterTest, stream_reporting_bounded) {
+        auto scope = tally::ScopeBuilder().prefix("bounded").build();
+        size_t streamed = 0;
+        std::vector<std::unique_ptr<StreamProbe>> probes;
+        for (int i = 0; i < 300; ++i) {
+            probes.push_back(std::make_unique<StreamProbe>(&streamed, "p" + std::to_string(i), scope.get()));
+        }
+        constexpr size_t kChunkSize = 256;
+        tally::ReportOptions options;
+        options.parallelism(4);
+        std::string out;
+        ASSERT_TRUE(tally::Reporter::stream_reporting([&](std::string_view chunk) {
+            out.append(chunk);
+            streamed += chunk.size();
+            return true;
+        }, tally::ExpositionFormat::kPrometheusText, &options, kChunkSize));
+        // What was rendered before a probe but not yet streamed out when it
+        // was read stayed buffered, at most one chunk.
+        for (auto &p: probes) {
+            const auto pos = out.find("# TYPE " + p->full_name() + " gauge\n");
+            ASSERT_NE(std::string::npos, pos);
+            ASSERT_LE(pos, p->streamed_at_read + kChunkSize) << p->full_name();
+        }
+    }
+
+    TEST(ReporterTest, cached_reporting) {
+        using tally::ExpositionFormat;
+        tally::Counter<int64_t> counter("cached_requests", "");
+        counter.increment();
+        tally::Reporter::clear_reporting_cache();
+        auto first = tally::Reporter::get_cached_reporting(ExpositionFormat::kPrometheusText, nullptr, 100000);
+        ASSERT_NE(std::string::npos, first->find(counter.full_name()));
+        auto second = tally::Reporter::get_cached_reporting(ExpositionFormat::kPrometheusText, nullptr, 100000);
+        ASSERT_EQ(first, second);
+
+        // formats and filters are cached apart.
+        auto om = tally::Reporter::get_cached_reporting(ExpositionFormat::kOpenMetricsText, nullptr, 100000);
+        ASSERT_NE(first, om);
+        tally::ReportOptions options;
+        options.build_filter("*cached_requests*", "");
+        auto filtered = tally::Reporter::get_cached_reporting(ExpositionFormat::kPrometheusText, &options, 100000);
+        ASSERT_NE(first, filtered);
+
+        auto expired = tally::Reporter::get_cached_reporting(ExpositionFormat::kPrometheusText, nullptr, -1);
+        ASSERT_NE(first, expired);
+
+        // concurrent misses render once.
+        tally::Reporter::clear_reporting_cache();
+        std::vector<std::shared_ptr<const std::string>> outputs(8);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            threads.emplace_back([&outputs, i] {
+                outputs[i] = tally::Reporter::get_cached_reporting(ExpositionFormat::kProtobufDelimited, nullptr, 100000);
+            });
+        }
+        for (auto &t: threads) {
+            t.join();
+        }
+        for (auto &o: outputs) {
+            ASSERT_EQ(outputs[0], o);
+        }
+
+        // arbitrary filters do not grow the cache without bound.
+        for (size_t i = 0; i < tally::Reporter::kMaxCachedReportings + 8; ++i) {
+            tally::ReportOptions each;
+            each.build_filter("*cached_" + std::to_string(i) + "*", "");
+            ASSERT_TRUE(tally::Reporter::get_cached_reporting(ExpositionFormat::kPrometheusText, &each, 100000));
+        }
+        ASSERT_EQ(tally::Reporter::kMaxCachedReportings, tally::Reporter::instance()._cache.size());
+
+        auto text = tally::Reporter::get_prometheus_reporting();
+        ASSERT_NE(std::string::npos, text.find("scrape_cache_hit"));
+        ASSERT_NE(std::string::npos, text.find("scrape_cache_miss"));
+    }
+
+    TEST(ReporterTest, summary) {
+        auto scope = tally::ScopeBuilder().prefix("sm").build();
+        tally::LatencyRecorder rec("rpc", "rpc latency", scope.get(), 10, {0.99, 0.5, 0.99});
+        ASSERT_EQ(std::vector<double>({0.5, 0.99}), rec.quantiles());
+        ASSERT_FALSE(rec.set_quantiles({0.9}).ok());
+        for (int i = 1; i <= 100; ++i) {
+            rec << i;
+        }
+        auto *summary = &rec._latency_summary;
+        ASSERT_TRUE(summary->type().is_summary());
+        ASSERT_TRUE(summary->type().is_metric());
+
+        std::stringstream text;
+        tally::PrometheusStatsReporter prometheus(text);
+        prometheus.report_variable(summary, turbo::Time::from_milliseconds(0));
+        auto &name = summary->full_name();
+        ASSERT_EQ(name.size() - strlen("rpc_latency_summary"), name.find("rpc_latency_summary"));
+        auto out = text.str();
+        ASSERT_NE(std::string::npos, out.find("# TYPE " + name + " summary\n"));
+        ASSERT_NE(std::string::npos, out.find(name + "{quantile=\"0.5\"} "));
+        ASSERT_NE(std::string::npos, out.find(name + "{quantile=\"0.99\"} "));
+        ASSERT_NE(std::string::npos, out.find(name + "_sum 5050\n"));
+        ASSERT_NE(std::string::npos, out.find(name + "_count 100\n"));
+        ASSERT_EQ(1UL, prometheus.state.summary_count);
+
+        std::stringstream om;
+        tally::PrometheusStatsReporter openmetrics(om, true);
+        openmetrics.report_variable(summary, turbo::Time::from_milliseconds(0));
+        ASSERT_NE(std::string::npos, om.str().find(name + "_created "));
+
+        std::stringstream pb;
+        tally::ProtobufStatsReporter protobuf(pb);
+        protobuf.report_variable(summary, turbo::Time::from_milliseconds(0));
+        auto families = parse_families(pb.str());
+        auto &f = families[name];
+        ASSERT_EQ(2UL, find_fields(f, 3)[0]->varint);
+        auto metric = parse_message(find_fields(f, 4)[0]->bytes);
+        auto value = parse_message(find_fields(metric, 4)[0]->bytes);
+        ASSERT_EQ(100UL, find_fields(value, 1)[0]->varint);
+        ASSERT_EQ(5050, find_fields(value, 2)[0]->fixed);
+        auto quantiles = find_fields(value, 3);
+        ASSERT_EQ(2UL, quantiles.size());
+        ASSERT_EQ(0.99, find_fields(parse_message(quantiles[1]->bytes), 1)[0]->fixed);
+
+        // The summary replaces the gauges of percentiles.
+        std::vector<std::string> names;
+        tally::Variable::list_exposed(&names);
+        for (auto &n: names) {
+            ASSERT_EQ(std::string::npos, n.find("rpc_latency_99")) << n;
+        }
+    }
+    enum class StatusClass { k2xx, k4xx, k5xx };
+    constexpr std::string_view kStatusClasses[] = {"2xx", "4xx", "5xx"};
+
+    TEST(ReporterTest, metric_array) {
+        auto scope = tally::ScopeBuilder().prefix("ma").build();
+        tally::MetricArray<tally::Counter<int64_t>, 3> responses("responses", "responses", "class",
+                                                                kStatusClasses, scope.get());
+        responses[StatusClass::k2xx] << 3;
+        std::thread th([&responses] {
+            responses[StatusClass::k4xx] << 2;
+        });
+        th.join();
+        responses[StatusClass::k4xx] << 1;
+        ASSERT_EQ(3, responses.get_value(StatusClass::k2xx));
+        ASSERT_EQ(3, responses.get_value(StatusClass::k4xx));
+        ASSERT_EQ(0, responses[StatusClass::k5xx].get_value());
+        ASSERT_EQ(3UL, responses.num_children());
+        std::vector<tally::VariableChild> children;
+        responses.children(turbo::Time(), &children);
+        ASSERT_EQ(3UL, children.size());
+        ASSERT_EQ("4xx", children[1].labels["class"]);
+        ASSERT_EQ(3.0, std::get<double>(children[1].sample.value));
+
+        auto &name = responses.full_name();
+        PrometheusText text;
+        text.report(&responses);
+        ASSERT_TRUE(text.has_type(name, "counter"));
+        ASSERT_TRUE(text.contains(name + "{class=\"2xx\"} 3"));
+        ASSERT_TRUE(text.contains(name + "{class=\"4xx\"} 3"));
+        ASSERT_TRUE(text.contains(name + "{class=\"5xx\"} 0"));
+
+        std::stringstream pb;
+        tally::ProtobufStatsReporter protobuf(pb);
+        protobuf.report_variable(&responses, turbo::Time::from_milliseconds(0));
+        auto families = parse_families(pb.str());
+        ASSERT_EQ(3UL, find_fields(families[name], 4).size());
+
+        auto buckets = tally::Buckets::linear_values(1.0, 1.0, 3);
+        tally::HistogramArray<3> latency(buckets, "latency", "latency", "class", kStatusClasses, scope.get());
+        latency[StatusClass::k2xx].record(1.5);
+        latency[StatusClass::k5xx].record(2.5);
+        latency[StatusClass::k5xx].record(2.5);
+        auto merged = std::get<tally::HistogramSample>(latency.get_metric(turbo::Time()).value);
+        ASSERT_EQ(3, merged.sample_count);
+
+        PrometheusText htext;
+        htext.report(&latency);
+        auto &hname = latency.full_name();
+        ASSERT_TRUE(htext.has_type(hname, "histogram"));
+        ASSERT_TRUE(htext.contains(hname + "_count{class=\"5xx\"} 2"));
+        ASSERT_TRUE(htext.contains(hname + "_count{class=\"4xx\"} 0"));
+        ASSERT_EQ(1UL, htext.reporter().state.hist_count);
+    }
+
+    TEST(ReporterTest, metric_array_of_one) {
+        auto scope = tally::ScopeBuilder().prefix("ma1").build();
+        constexpr std::string_view kOnly[] = {"2xx"};
+        tally::MetricArray<tally::Counter<int64_t>, 1> responses("responses", "responses", "class",
+                                                                kOnly, scope.get());
+        responses[0] << 3;
+        ASSERT_TRUE(PrometheusText().report(&responses).contains(responses.full_name() + "{class=\"2xx\"} 3"));
+
+        tally::HistogramArray<1> latency(tally::Buckets::linear_values(1.0, 1.0, 3), "latency", "latency",
+                                         "class", kOnly, scope.get());
+        latency[0].record(1.5);
+        ASSERT_TRUE(PrometheusText().report(&latency).contains(latency.full_name() + "_count{class=\"2xx\"} 1"));
+    }
+}  // namespace
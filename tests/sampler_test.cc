@@ -13,7 +13,9 @@
 // limitations under the License.
 //
 
+#include <algorithm>
 #include <limits>                           //std::numeric_limits
+#include <random>
 #include <tally/tally.h>
 #include <gtest/gtest.h>
 
@@ -115,4 +117,116 @@ namespace {
         sleep(1);
         EXPECT_EQ(100 * TURBO_ARRAYSIZE(th), (size_t) DebugSampler::_s_ndestroy);
     }
+
+    TEST(SamplerTest, sliding_window) {
+        tally::detail::SlidingWindow<int, tally::detail::MaxTo<int>> w{tally::detail::MaxTo<int>()};
+        int v = 0;
+        ASSERT_FALSE(w.get(&v));
+        std::vector<int> values;
+        std::mt19937 rand(7);
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(static_cast<int>(rand() % 1000));
+            w.push(values.back());
+            while (w.size() > static_cast<size_t>(i % 13)) {
+                w.pop();
+            }
+            if (w.size() == 0) {
+                ASSERT_FALSE(w.get(&v));
+                continue;
+            }
+            ASSERT_TRUE(w.get(&v));
+            ASSERT_EQ(*std::max_element(values.end() - w.size(), values.end()), v);
+        }
+    }
+
+    TEST(SamplerTest, non_invertible_window) {
+        tally::MaxerGauge<int64_t> maxer;
+        // Not scheduled, samples are taken by hand.
+        tally::MaxerGauge<int64_t>::sampler_type sampler(&maxer);
+        ASSERT_EQ(0, sampler.set_window_size(60));
+        std::vector<int64_t> values;
+        std::mt19937 rand(7);
+        const std::vector<time_t> sizes = {1, 2, 3, 5, 7, 10, 20, 30, 45, 60};
+        for (int tick = 0; tick < 200; ++tick) {
+            values.push_back(static_cast<int64_t>(rand() % 100000));
+            maxer << values.back();
+            sampler.take_sample();
+            for (auto size: sizes) {
+                tally::detail::Sample<int64_t> result;
+                ASSERT_TRUE(sampler.get_value(size, &result));
+                const size_t n = std::min<size_t>(size, std::min<size_t>(values.size(), 60));
+                ASSERT_EQ(*std::max_element(values.end() - n, values.end()), result.data)
+                                            << "tick=" << tick << " size=" << size;
+            }
+        }
+    }
+
+    TEST(SamplerTest, percentile_window) {
+        tally::detail::Percentile percentile;
+        tally::detail::Percentile::sampler_type sampler(&percentile);
+        ASSERT_EQ(0, sampler.set_window_size(10));
+        for (int tick = 0; tick < 20; ++tick) {
+            for (uint32_t i = 0; i < 100; ++i) {
+                percentile << tick * 100 + i;
+            }
+            sampler.take_sample();
+        }
+        tally::detail::Sample<tally::detail::GlobalPercentileSamples> result;
+        ASSERT_TRUE(sampler.get_value(5, &result));
+        // Reduced from the samples of the sampler, with no copies kept.
+        ASSERT_TRUE(sampler._windows.empty());
+        ASSERT_EQ(500u, result.data._num_added);
+        ASSERT_LE(1500, result.data.get_number(0.01));
+        ASSERT_GE(1999, result.data.get_number(1));
+    }
+
+    TEST(SamplerTest, missed_ticks) {
+        tally::Counter<int64_t> adder;
+        tally::Counter<int64_t>::sampler_type sampler(&adder);
+        ASSERT_EQ(0, sampler.set_window_size(3));
+        const int64_t base = (turbo::Time::current_microseconds() / 1000000 + 10) * 1000000;
+        auto tick = [&](int64_t second, int64_t value) {
+            adder << value;
+            sampler._tick_us = base + second * 1000000;
+            sampler.take_sample();
+            sampler._tick_us = 0;
+        };
+        tick(1, 1);
+        tick(2, 2);
+        tick(3, 4);
+        tally::detail::Sample<int64_t> result;
+        ASSERT_TRUE(sampler.get_value(2, &result));
+        ASSERT_EQ(6, result.data);
+        ASSERT_EQ(2000000, result.time_us);
+        // Ticks of second 4 and 5 are missed, the window keeps to what is
+        // sampled in the last 3 seconds.
+        tick(6, 8);
+        ASSERT_TRUE(sampler.get_value(3, &result));
+        ASSERT_EQ(8, result.data);
+        ASSERT_EQ(3000000, result.time_us);
+        tick(7, 16);
+        ASSERT_TRUE(sampler.get_value(3, &result));
+        ASSERT_EQ(24, result.data);
+        ASSERT_EQ(4000000, result.time_us);
+        ASSERT_TRUE(sampler.get_value(1, &result));
+        ASSERT_EQ(16, result.data);
+        ASSERT_EQ(1000000, result.time_us);
+
+        tally::MaxerGauge<int64_t> maxer;
+        tally::MaxerGauge<int64_t>::sampler_type max_sampler(&maxer);
+        ASSERT_EQ(0, max_sampler.set_window_size(3));
+        auto max_tick = [&](int64_t second, int64_t value) {
+            maxer << value;
+            max_sampler._tick_us = base + second * 1000000;
+            max_sampler.take_sample();
+            max_sampler._tick_us = 0;
+        };
+        max_tick(1, 9);
+        max_tick(2, 1);
+        ASSERT_TRUE(max_sampler.get_value(3, &result));
+        ASSERT_EQ(9, result.data);
+        max_tick(5, 2);
+        ASSERT_TRUE(max_sampler.get_value(3, &result));
+        ASSERT_EQ(2, result.data);
+    }
 } // namespace
@@ -0,0 +1,67 @@
+// Copyright (C) Kumo inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tally/tally.h>
+#include "prometheus_text.h"
+
+TEST(TopKTest, heavy_hitters) {
+    tally::TopK hot(2, 60, "top_k_test", "hot keys", "tenant");
+    // Heavy keys among many light ones, from two threads.
+    auto add = [&hot](int seed) {
+        for (int i = 0; i < 20000; ++i) {
+            if (i % 4 == 0) {
+                hot << "a";
+            } else if (i % 4 == 1) {
+                hot.add("b", 1);
+            } else {
+                hot << std::to_string(seed + i);
+            }
+        }
+    };
+    std::thread th(add, 0);
+    add(1000000);
+    th.join();
+    usleep(1100000);
+    auto top = hot.get_value();
+    ASSERT_EQ(2UL, top.size());
+    for (auto &e: top) {
+        ASSERT_TRUE(e.key == "a" || e.key == "b") << e.key;
+        ASSERT_LE(10000, e.count);
+        ASSERT_LE(e.count - e.error, 10000);
+    }
+    ASSERT_EQ(4UL, hot.num_children());
+    // Keys and counts of one report come from the same entries.
+    std::vector<tally::VariableChild> children;
+    hot.children(turbo::Time(), &children);
+    ASSERT_EQ(4UL, children.size());
+    for (size_t i = 0; i < children.size(); ++i) {
+        auto &e = top[i / 2];
+        ASSERT_EQ(e.key, children[i].labels["tenant"]);
+        ASSERT_EQ(i % 2 == 0 ? "count" : "error", children[i].labels["stat"]);
+        ASSERT_EQ(static_cast<double>(i % 2 == 0 ? e.count : e.error),
+                  std::get<double>(children[i].sample.value));
+    }
+
+    PrometheusText text;
+    text.report(&hot);
+    ASSERT_TRUE(text.has_type(hot.full_name(), "gauge"));
+    ASSERT_TRUE(text.contains("tenant=\"a\""));
+    ASSERT_TRUE(text.contains("stat=\"error\""));
+}
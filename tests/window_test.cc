@@ -19,6 +19,7 @@
 #include <list>
 #include <iostream>
 #include <sstream>
+#include <thread>
 #include <gtest/gtest.h>
 #include <tally/tally.h>
 
@@ -90,3 +91,48 @@ TEST_F(WindowTest, window) {
     ASSERT_EQ(recorder_stat.get_average_int(), window_ex_recorder_stat.get_average_int());
     ASSERT_DOUBLE_EQ(recorder_stat.get_average_double(), window_ex_recorder_stat.get_average_double());
 }
+
+TEST_F(WindowTest, sub_second_window) {
+    tally::Counter<int> adder;
+    tally::Window<tally::Counter<int> > window(&adder, turbo::Duration::milliseconds(300),
+                                               turbo::Duration::milliseconds(100));
+    tally::PerSecond<tally::Counter<int> > per_second(&adder, turbo::Duration::seconds(1),
+                                                      turbo::Duration::milliseconds(100));
+    ASSERT_EQ(3, window.window_size());
+    ASSERT_EQ(10, per_second.window_size());
+    ASSERT_EQ(10, window.samples_per_second());
+    ASSERT_EQ(turbo::Duration::milliseconds(300), window.window());
+    // The period is fixed once a window is set.
+    ASSERT_EQ(-1, adder.get_sampler()->set_sampling_period_us(1000000));
+    ASSERT_EQ(-1, adder.get_sampler()->set_sampling_period_us(300000));
+
+    adder << 10;
+    usleep(700000);
+    // The value fell out of the 300ms window, but is still in the last second.
+    ASSERT_EQ(0, window.get_value());
+    ASSERT_NE(0, per_second.get_value());
+    adder << 5;
+    usleep(150000);
+    ASSERT_EQ(5, window.get_value());
+
+    tally::MaxerGauge<int> maxer;
+    tally::Window<tally::MaxerGauge<int> > window_maxer(&maxer, turbo::Duration::milliseconds(200),
+                                                        turbo::Duration::milliseconds(50));
+    maxer << 7;
+    usleep(120000);
+    ASSERT_EQ(7, window_maxer.get_value());
+    usleep(300000);
+    ASSERT_NE(7, window_maxer.get_value());
+}
+
+TEST_F(WindowTest, aligned_ticks) {
+    tally::Counter<int> adder;
+    tally::Window<tally::Counter<int> > window(&adder, turbo::Duration::milliseconds(100),
+                                               turbo::Duration::milliseconds(100));
+    usleep(350000);
+    tally::detail::Sample<int> span;
+    ASSERT_TRUE(window.get_span(&span));
+    // Samples are stamped with their scheduled ticks.
+    ASSERT_EQ(100000, span.time_us);
+    ASSERT_EQ(0, window._sampler->_q.bottom()->time_us % 100000);
+}